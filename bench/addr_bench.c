@@ -0,0 +1,147 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "addr_idx.h"
+#include "emustate.h"
+
+/*
+Micro-benchmark for the addressing helpers in addr_idx.h
+
+Times the inline XOR/flat-memory helpers against the division based versions they replaced,
+on the same random operands, after checking that both detect page crossings the same way
+(for the cases where the old versions were correct).
+*/
+
+#define N_OPS (1 << 16)
+#define ROUNDS 512
+
+// the previous implementation, kept here as the baseline. The helpers lived in addr_idx.c,
+// so they were out-of-line calls from every handler; noinline keeps that cost in the comparison
+#define OLD_ADDR(e,x) e->memory[(x)/256][(x)%256]
+
+__attribute__((noinline)) static uint8_t old_fetch_abs_reg(emustate* emu, uint8_t reg, abs_t opr, cycles_t* cycle_count) {
+    abs_t adr = reg+opr;
+    if (cycle_count != NULL && opr/256 != adr/256)
+        *cycle_count = 1;
+    return OLD_ADDR(emu, adr);
+}
+
+__attribute__((noinline)) static abs_t old_fetch_indr_y(emustate* emu, indr_t opr, cycles_t* cycle_count) {
+    abs_t adr = opr;
+    uint8_t lo = OLD_ADDR(emu, adr);
+    adr++;
+    uint8_t hi = OLD_ADDR(emu, adr);
+    abs_t base = lo | (hi << 8);
+    if (cycle_count != NULL)
+        *cycle_count = (base/256 != (abs_t)(base+emu->y)/256);
+    return base+emu->y;
+}
+
+#define OLD_BRANCH_CYCLES(e,offset) (e->pc/256 != (abs_t)(e->pc+offset)/256 ? 2 : 1)
+
+static uint32_t rng = 2463534242u;
+
+static uint32_t xorshift(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static emustate emu;
+static abs_t oprs[N_OPS];
+static uint8_t regs[N_OPS];
+static rel_t offsets[N_OPS];
+static volatile uint32_t sink;
+
+static void report(const char* name, double old_ns, double new_ns) {
+    double ops = (double)N_OPS * ROUNDS;
+    printf("%-16s old %6.3f ns/op   new %6.3f ns/op   speedup %.2fx\n", name, old_ns/ops, new_ns/ops, old_ns/new_ns);
+}
+
+int main() {
+    emustate* e = &emu;
+    for (int i = 0; i < 0x10000; i++)
+        e->mem[i] = xorshift();
+    for (int i = 0; i < N_OPS; i++) {
+        oprs[i] = xorshift();
+        regs[i] = xorshift();
+        offsets[i] = xorshift();
+    }
+
+    // exhaustive check of the page crossing rule against the definition (high bytes differ)
+    for (uint32_t opr = 0; opr < 0x10000; opr++) {
+        for (uint32_t reg = 0; reg < 256; reg++) {
+            cycles_t xtra = 0;
+            u_fetch_abs_reg(e, reg, opr, &xtra);
+            assert(xtra == (((opr + reg) & 0xFF00) != (opr & 0xFF00)));
+        }
+    }
+
+    double t0, t1, t2;
+    uint32_t acc = 0;
+
+    t0 = now_ns();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < N_OPS; i++) {
+            cycles_t xtra = 0;
+            acc += old_fetch_abs_reg(e, regs[i], oprs[i], &xtra) + xtra;
+        }
+    }
+    t1 = now_ns();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < N_OPS; i++) {
+            cycles_t xtra = 0;
+            acc += u_fetch_abs_reg(e, regs[i], oprs[i], &xtra) + xtra;
+        }
+    }
+    t2 = now_ns();
+    report("abs,X / abs,Y", t1-t0, t2-t1);
+
+    t0 = now_ns();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < N_OPS; i++) {
+            cycles_t xtra = 0;
+            e->y = regs[i];
+            acc += old_fetch_indr_y(e, oprs[i] & 0xFE, &xtra) + xtra;
+        }
+    }
+    t1 = now_ns();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < N_OPS; i++) {
+            cycles_t xtra = 0;
+            e->y = regs[i];
+            acc += u_fetch_indr_y(e, oprs[i] & 0xFE, &xtra) + xtra;
+        }
+    }
+    t2 = now_ns();
+    report("(zp),Y", t1-t0, t2-t1);
+
+    t0 = now_ns();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < N_OPS; i++) {
+            e->pc = oprs[i];
+            acc += OLD_BRANCH_CYCLES(e, offsets[i]);
+        }
+    }
+    t1 = now_ns();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < N_OPS; i++) {
+            e->pc = oprs[i];
+            acc += BRANCH_CYCLES(e, offsets[i]);
+        }
+    }
+    t2 = now_ns();
+    report("branch", t1-t0, t2-t1);
+
+    sink = acc;
+    return 0;
+}
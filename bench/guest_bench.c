@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "addr_idx.h"
+#include "asm.h"
+#include "lib6502emu.h"
+#include "predecode.h"
+
+/*
+Guest benchmark suite, run by `make bench`
+
+Every workload in bench/workloads is assembled at $0400 and run headless until its final BRK, once
+per core (the plain interpreter and the predecoded dispatch), best of RUNS. Instructions are counted
+in a separate untimed run. Results are printed and written to bench_output.txt, one line per
+workload and core, as key=value pairs so runs can be compared across commits.
+*/
+
+#define RUNS 5
+
+static const char* workloads[] = {
+    "sieve", "crc16", "crc32", "bubble", "bcd", "dhry", "memcpy"
+};
+
+static char source[0x10000];
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int load(emustate* emu, const char* dir, const char* name) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s.asm", dir, name);
+    FILE* f = fopen(path, "r");
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+    source[fread(source, 1, sizeof(source)-1, f)] = 0;
+    fclose(f);
+
+    emu_reset(emu);
+    asm_result res;
+    if (asm_assemble(emu, source, 0x0400, &res) != 0) {
+        printf("%s: line %d: %s\n", path, res.error_line, res.error);
+        return -1;
+    }
+    emu->pc = res.start;
+    return 0;
+}
+
+/*
+return: number of instructions executed up to and including the final BRK
+*/
+static uint64_t count_instructions(emustate* emu) {
+    uint64_t n = 0;
+    for (;;) {
+        uint8_t opcode = ADDR(emu, emu->pc);
+        if (emu_step(emu) == 0)
+            return n;
+        n++;
+        if (opcode == 0x00)
+            return n;
+    }
+}
+
+int main(int argc, char** argv) {
+    const char* dir = argc > 1 ? argv[1] : "bench/workloads";
+    const char* out_path = argc > 2 ? argv[2] : "bench_output.txt";
+    const char* commit = argc > 3 ? argv[3] : "unknown";
+
+    FILE* out = fopen(out_path, "w");
+    if (out == NULL) {
+        perror(out_path);
+        return 1;
+    }
+    emustate* emu = emu_create();
+    decode_cache* cache = emu->cache;
+
+    printf("%-8s %-10s %12s %12s %10s %10s %8s\n", "workload", "core", "cycles", "instrs", "MHz", "ns/instr", "MIPS");
+    for (int w = 0; w < sizeof(workloads)/sizeof(workloads[0]); w++) {
+        emu->cache = NULL;
+        if (load(emu, dir, workloads[w]))
+            return 1;
+        uint64_t instrs = count_instructions(emu);
+
+        for (int core = 0; core <= 1; core++) {
+            const char* core_name = core ? "predecode" : "interp";
+            double best = 0;
+            uint64_t cycles = 0;
+            for (int r = 0; r < RUNS; r++) {
+                emu->cache = NULL;
+                load(emu, dir, workloads[w]);
+                if (core) {
+                    emu->cache = cache;
+                    decode_cache_flush(cache);
+                }
+                uint64_t start = emu->cycles;
+                double t0 = now_s();
+                int stop = emu_run_until(emu, UINT64_MAX, STOP_BRK);
+                double t = now_s() - t0;
+                if (stop != STOP_BRK) {
+                    printf("%s: stopped with reason %d at $%04x\n", workloads[w], stop, emu->pc);
+                    return 1;
+                }
+                cycles = emu->cycles - start;
+                if (r == 0 || t < best)
+                    best = t;
+            }
+            double mhz = cycles / best / 1e6;
+            double ns = best * 1e9 / instrs;
+            printf("%-8s %-10s %12llu %12llu %10.2f %10.2f %8.2f\n", workloads[w], core_name,
+                (unsigned long long)cycles, (unsigned long long)instrs, mhz, ns, 1e3 / ns);
+            fprintf(out, "commit=%s workload=%s core=%s cycles=%llu instructions=%llu seconds=%.6f mhz=%.3f ns_per_instr=%.3f mips=%.3f\n",
+                commit, workloads[w], core_name, (unsigned long long)cycles, (unsigned long long)instrs, best, mhz, ns, 1e3 / ns);
+        }
+    }
+
+    emu->cache = cache;
+    emu_destroy(emu);
+    fclose(out);
+    return 0;
+}
@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "addr_idx.h"
+#include "instr_map.h"
+#include "lib6502emu.h"
+#include "predecode.h"
+
+/*
+Per-handler micro-benchmark, run by `make microbench`
+
+Every handler in instr_map is called through its fptr in a tight loop. Each iteration loads one of
+N_STATES random register sets (A, X, Y, SR including the decimal flag, SP) and operands, over
+memory filled with random bytes. The cost of that loop with an empty handler is measured first and
+subtracted, so the numbers are the handler alone.
+
+The dispatch path is timed on its own by running memory full of NOPs through the plain interpreter
+and the predecoded dispatch, minus the NOP handler.
+*/
+
+#define N_STATES 4096
+#define ITERS (1 << 22)
+
+typedef struct bench_state {
+    uint8_t a, x, y, sr, sp;
+    uint16_t opr;
+} bench_state;
+
+static emustate emu;
+static bench_state states[N_STATES];
+static volatile cycles_t sink;
+
+static const char* mode_names[MODE_COUNT] = {
+    "impl", "A", "#imd", "zpg", "zpg,X", "zpg,Y", "abs", "abs,X", "abs,Y", "(ind)", "(ind,X)", "(ind),Y", "rel"
+};
+
+static uint32_t rng = 2463534242u;
+
+static uint32_t xorshift(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+__attribute__((noinline)) static cycles_t empty(emustate* emu, abs_t opr) {
+    return 0;
+}
+
+// called through a pointer the compiler can't see through, like the handlers
+static cycles_t (*volatile empty_ptr) (emustate*, abs_t) = empty;
+
+/*
+loop calling call(fn) ITERS times with a fresh random state each time
+return: ns per iteration
+*/
+#define TIME_LOOP(call) ({ \
+        cycles_t acc = 0; \
+        double t0 = now_ns(); \
+        for (int n = 0; n < ITERS; n++) { \
+            const bench_state* s = &states[n & (N_STATES-1)]; \
+            emu.a = s->a; emu.x = s->x; emu.y = s->y; emu.sr = s->sr; emu.sp = s->sp; \
+            acc += call; \
+        } \
+        sink = acc; \
+        (now_ns() - t0) / ITERS; \
+    })
+
+static double time_handler(const instr_info* i) {
+    union instruction_func f = i->fptr;
+    switch (i->type) {
+        case Implied:   return TIME_LOOP(f.implied(&emu));
+        case Immediate: return TIME_LOOP(f.immediate(&emu, s->opr & 0xFF));
+        case Zeropage:  return TIME_LOOP(f.zpg(&emu, s->opr));
+        case Absolute:  return TIME_LOOP(f.absolute(&emu, s->opr));
+        case Indirect:  return TIME_LOOP(f.indirect(&emu, (i->mode == Ind) ? s->opr : (s->opr & 0xFF)));
+        case Relative:  return TIME_LOOP(f.relative(&emu, s->opr));
+    }
+    return 0;
+}
+
+/*
+return: ns per instruction running NOPs
+*/
+static double time_nops(int cached) {
+    emu_reset(&emu);
+    memset(emu.mem, 0xEA, sizeof(emu.mem));
+    if (cached)
+        decode_cache_flush(emu.cache);
+    struct decode_cache* cache = emu.cache;
+    if (!cached)
+        emu.cache = NULL;
+    emu_run(&emu, 0x20000); //warm up, every slot decoded
+    double t0 = now_ns();
+    uint64_t cycles = emu_run(&emu, (uint64_t)ITERS * 2);
+    double t = now_ns() - t0;
+    emu.cache = cache;
+    return t / (cycles / 2);
+}
+
+int main() {
+    emu_init(&emu);
+    emu.cache = decode_cache_create();
+    for (int k = 0; k < N_STATES; k++) {
+        states[k] = (bench_state){xorshift(), xorshift(), xorshift(), xorshift() | (1 << 5), xorshift(), xorshift()};
+    }
+
+    cycles_t (*baseline) (emustate*, abs_t) = empty_ptr;
+    double base = TIME_LOOP(baseline(&emu, s->opr));
+    printf("loop overhead %.2f ns, subtracted below\n\n", base);
+    printf("opc  name  mode       ns/op\n");
+    double nop = 0;
+    for (int opc = 0; opc < 256; opc++) {
+        const instr_info* i = instr_map[opc];
+        if (i == NULL)
+            continue;
+        for (int k = 0; k < sizeof(emu.mem); k++)
+            emu.mem[k] = xorshift();
+        double t = time_handler(i) - base;
+        if (opc == 0xEA)
+            nop = t;
+        printf("$%02x  %s   %-8s %7.2f\n", opc, i->name, mode_names[i->mode], t);
+    }
+
+    double plain = time_nops(0), cached = time_nops(1);
+    printf("\ndispatch (per instruction, NOP handler excluded)\n");
+    printf("interpreter  %7.2f ns\n", plain - nop);
+    printf("predecoded   %7.2f ns\n", cached - nop);
+
+    decode_cache_free(emu.cache);
+    return 0;
+}
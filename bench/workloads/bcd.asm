@@ -0,0 +1,43 @@
+; decimal mode arithmetic: a 4 byte BCD counter counting up and a 2 byte one counting down, 51200 times
+
+up   = $10
+down = $14
+
+        .org $0400
+        SED
+        LDA #0
+        STA up
+        STA up+1
+        STA up+2
+        STA up+3
+        LDA #$99
+        STA down
+        STA down+1
+        LDY #200
+        LDX #0
+count:  CLC
+        LDA up
+        ADC #$01
+        STA up
+        LDA up+1
+        ADC #0
+        STA up+1
+        LDA up+2
+        ADC #0
+        STA up+2
+        LDA up+3
+        ADC #0
+        STA up+3
+        SEC
+        LDA down
+        SBC #$01
+        STA down
+        LDA down+1
+        SBC #0
+        STA down+1
+        DEX
+        BNE count
+        DEY
+        BNE count
+        CLD
+        BRK
@@ -0,0 +1,42 @@
+; bubble sort of 256 bytes in descending order, 2 times
+
+arr     = $0200
+swapped = $10
+reps    = $11
+
+        .org $0400
+        LDA #2
+        STA reps
+rep:    LDX #0
+init:   TXA
+        EOR #$ff
+        STA arr,X
+        INX
+        BNE init
+
+pass:   LDA #0
+        STA swapped
+        LDX #0
+compare:
+        LDA arr,X
+        CMP arr+1,X
+        BCC inorder
+        BEQ inorder
+        TAY
+        LDA arr+1,X
+        STA arr,X
+        TYA
+        STA arr+1,X
+        LDA #1
+        STA swapped
+inorder:
+        INX
+        CPX #$ff
+        BNE compare
+        LDA swapped
+        CMP #0
+        BNE pass
+
+        DEC reps
+        BNE rep
+        BRK
@@ -0,0 +1,42 @@
+; CRC-16/CCITT, bit at a time, over the 16K at $0000-$3fff, 2 times
+
+crc  = $f0
+ptr  = $f2
+reps = $f4
+
+        .org $0400
+        LDA #2
+        STA reps
+rep:    LDA #$ff
+        STA crc
+        STA crc+1
+        LDA #0
+        STA ptr
+        STA ptr+1
+        LDY #0
+
+byte:   LDA (ptr),Y
+        EOR crc+1
+        STA crc+1
+        LDX #8
+bit:    ASL crc
+        ROL crc+1
+        BCC nopoly
+        LDA crc+1
+        EOR #$10
+        STA crc+1
+        LDA crc
+        EOR #$21
+        STA crc
+nopoly: DEX
+        BNE bit
+        INC ptr
+        BNE byte
+        INC ptr+1
+        LDA ptr+1
+        CMP #$40
+        BNE byte
+
+        DEC reps
+        BNE rep
+        BRK
@@ -0,0 +1,46 @@
+; CRC-32 (reflected, polynomial $edb88320), bit at a time, over the 8K at $0000-$1fff
+
+crc = $f0
+ptr = $f4
+
+        .org $0400
+        LDA #$ff
+        STA crc
+        STA crc+1
+        STA crc+2
+        STA crc+3
+        LDA #0
+        STA ptr
+        STA ptr+1
+        LDY #0
+
+byte:   LDA (ptr),Y
+        EOR crc
+        STA crc
+        LDX #8
+bit:    LSR crc+3
+        ROR crc+2
+        ROR crc+1
+        ROR crc
+        BCC nopoly
+        LDA crc+3
+        EOR #$ed
+        STA crc+3
+        LDA crc+2
+        EOR #$b8
+        STA crc+2
+        LDA crc+1
+        EOR #$83
+        STA crc+1
+        LDA crc
+        EOR #$20
+        STA crc
+nopoly: DEX
+        BNE bit
+        INC ptr
+        BNE byte
+        INC ptr+1
+        LDA ptr+1
+        CMP #$20
+        BNE byte
+        BRK
@@ -0,0 +1,106 @@
+; Dhrystone-style mix: calls, string copy and compare, record access through pointers,
+; arithmetic and logic on zero page variables, stack traffic. 4096 iterations
+
+iter  = $10
+int1  = $12
+int2  = $13
+int3  = $14
+rec   = $16     ; pointer to the current record
+str1  = $0300
+str2  = $0320
+recs  = $0340   ; two 16 byte records
+
+        .org $0400
+        LDA #0
+        STA iter
+        STA iter+1
+        LDX #29         ; str1 = "DHRYSTONE PROGRAM, 1'ST STRING"
+fillstr:
+        TXA
+        CLC
+        ADC #'A'
+        STA str1,X
+        DEX
+        BPL fillstr
+
+main:   JSR copy
+        JSR compare
+        JSR arith
+        JSR records
+        JSR records
+        INC iter
+        BNE main
+        INC iter+1
+        LDA iter+1
+        CMP #$10
+        BNE main
+        BRK
+
+copy:   LDX #29
+copy1:  LDA str1,X
+        STA str2,X
+        DEX
+        BPL copy1
+        RTS
+
+compare:
+        LDX #0
+cmp1:   LDA str1,X
+        CMP str2,X
+        BNE cmpdone
+        INX
+        CPX #30
+        BNE cmp1
+cmpdone:
+        STX int3
+        RTS
+
+arith:  LDA iter
+        STA int1
+        CLC
+        ADC #7
+        STA int2
+        PHA
+        SEC
+        SBC int1
+        AND #$0f
+        ORA #$40
+        EOR int2
+        STA int1
+        PLA
+        CMP int1
+        BCC less
+        INC int3
+less:   ASL int2
+        LSR int1
+        RTS
+
+records:
+        LDA iter        ; alternate between the two records
+        AND #1
+        ASL A
+        ASL A
+        ASL A
+        ASL A
+        CLC
+        ADC #<recs
+        STA rec
+        LDA #>recs
+        STA rec+1
+        LDY #0
+        LDA int1
+        STA (rec),Y
+        INY
+        LDA int2
+        STA (rec),Y
+        INY
+        LDA int3
+        STA (rec),Y
+        LDY #15
+rec1:   LDA (rec),Y
+        CLC
+        ADC #1
+        STA (rec),Y
+        DEY
+        BPL rec1
+        RTS
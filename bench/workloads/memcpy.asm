@@ -0,0 +1,29 @@
+; memcpy of 16K from $4000 to $8000 through (zp),Y, 4 times (64K copied)
+
+src  = $10
+dst  = $12
+reps = $14
+
+        .org $0400
+        LDA #4
+        STA reps
+rep:    LDA #0
+        STA src
+        STA dst
+        LDA #$40
+        STA src+1
+        LDA #$80
+        STA dst+1
+        LDY #0
+        LDX #$40
+copy:   LDA (src),Y
+        STA (dst),Y
+        INY
+        BNE copy
+        INC src+1
+        INC dst+1
+        DEX
+        BNE copy
+        DEC reps
+        BNE rep
+        BRK
@@ -0,0 +1,62 @@
+; Sieve of Eratosthenes over 8192 flags at $8000-$9fff, 8 times
+
+flags = $8000
+reps  = $10
+cand  = $12     ; pointer to the flag of the current candidate
+step  = $14     ; the candidate's value, the distance between its multiples
+ptr   = $16     ; pointer to the flag of the current multiple
+
+        .org $0400
+        LDA #8
+        STA reps
+
+rep:    LDA #1          ; every number starts as a candidate
+        LDY #0
+        STY ptr
+        LDX #>flags
+        STX ptr+1
+fill:   STA (ptr),Y
+        INY
+        BNE fill
+        INC ptr+1
+        LDX ptr+1
+        CPX #>flags+$20
+        BNE fill
+
+        LDA #2
+        STA cand
+        LDA #>flags
+        STA cand+1
+next:   LDY #0
+        LDA (cand),Y
+        CMP #0
+        BEQ skip
+        LDA cand        ; prime: clear every multiple
+        STA step
+        STA ptr
+        LDA cand+1
+        STA ptr+1
+        AND #$1f
+        STA step+1
+mark:   CLC
+        LDA ptr
+        ADC step
+        STA ptr
+        LDA ptr+1
+        ADC step+1
+        STA ptr+1
+        CMP #>flags+$20
+        BCS skip
+        LDA #0
+        STA (ptr),Y
+        JMP mark
+skip:   INC cand
+        BNE same
+        INC cand+1
+same:   LDA cand+1
+        CMP #>flags+$20
+        BNE next
+
+        DEC reps
+        BNE rep
+        BRK
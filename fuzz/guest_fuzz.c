@@ -0,0 +1,206 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "addr_idx.h"
+#include "instr_map.h"
+#include "lib6502emu.h"
+
+/*
+Coverage-guided fuzzing harness for guest code
+
+Each input is run in an emustate under a cycle budget, and every PC-to-PC transition is counted in
+fuzz_edges, a 64K map of 8-bit counters indexed by (previous PC >> 1) ^ PC, as AFL does for host code.
+
+What an input is depends on FUZZ_TARGET:
+    unset   the input is a program, loaded at FUZZ_LOAD (default 4000) and run from there
+    set     a ROM image (.bin) loaded once at FUZZ_LOAD, the input is data: it is placed at FUZZ_DATA
+            (default 0400), its length goes to $00/$01, and the ROM runs from FUZZ_ENTRY
+            (default FUZZ_LOAD)
+A run ends at the first BRK or invalid opcode, or after FUZZ_CYCLES (default 10000). If FUZZ_CRASH
+is set, reaching that address aborts, so a guest's failure handler shows up as a crash. Addresses
+are hex.
+
+The harness is persistent: memory is not reset between inputs, instead the pages the previous run
+wrote (HOOK_DIRTY) or the input was loaded into are copied back from the initial image.
+
+Builds:
+    make bin/guest_fuzz                 standalone driver, runs files given as arguments, -n times each,
+                                        and prints executions per second and edges hit
+    clang -fsanitize=fuzzer -DFUZZ_LIBFUZZER ...
+                                        libFuzzer, fuzz_edges is placed in its extra counters
+    afl-clang-fast -DFUZZ_AFL ...       AFL++ persistent mode, edges go into the AFL map as well
+*/
+
+#define FUZZ_MAP_SIZE 0x10000
+
+#ifdef FUZZ_LIBFUZZER
+__attribute__((section("__libfuzzer_extra_counters")))
+#endif
+uint8_t fuzz_edges[FUZZ_MAP_SIZE];
+
+#ifdef FUZZ_AFL
+extern uint8_t* __afl_area_ptr;
+#endif
+
+static emustate* emu;
+static uint8_t image[0x10000];
+static abs_t load_adr = 0x4000, data_adr = 0x0400, entry;
+static int data_mode;
+static uint64_t max_cycles = 10000;
+static long crash_adr = -1;
+
+static long env_hex(const char* name, long def) {
+    const char* v = getenv(name);
+    return v != NULL ? strtol(v, NULL, 16) : def;
+}
+
+/*
+copy every page marked in emu->dirty back from the initial image and clear the marks
+*/
+static void reset_dirty(void) {
+    for (int k = 0; k < 32; k++) {
+        uint8_t bits = emu->dirty[k];
+        while (bits != 0) {
+            int page = k * 8 + __builtin_ctz(bits);
+            memcpy(emu->memory[page], image + page * 256, 256);
+            bits &= bits - 1;
+        }
+        emu->dirty[k] = 0;
+    }
+}
+
+int LLVMFuzzerInitialize(int* argc, char*** argv) {
+    emu = emu_create();
+    if (emu == NULL)
+        abort();
+    emu_track_dirty(emu, 1);
+    load_adr = env_hex("FUZZ_LOAD", 0x4000);
+    data_adr = env_hex("FUZZ_DATA", 0x0400);
+    crash_adr = env_hex("FUZZ_CRASH", -1);
+    const char* cycles = getenv("FUZZ_CYCLES");
+    if (cycles != NULL)
+        max_cycles = strtoull(cycles, NULL, 0);
+    const char* target = getenv("FUZZ_TARGET");
+    if (target != NULL) {
+        FILE* f = fopen(target, "rb");
+        if (f == NULL) {
+            perror(target);
+            exit(2);
+        }
+        uint8_t rom[0x10000];
+        size_t len = fread(rom, 1, 0x10000 - load_adr, f);
+        fclose(f);
+        memcpy(image + load_adr, rom, len);
+        data_mode = 1;
+    }
+    entry = env_hex("FUZZ_ENTRY", load_adr);
+    memcpy(emu->mem, image, sizeof(image));
+    return 0;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (emu == NULL)
+        LLVMFuzzerInitialize(NULL, NULL);
+    reset_dirty();
+
+    // the input goes straight into memory, only the pages it covers have to be restored afterwards
+    abs_t adr = data_mode ? data_adr : load_adr;
+    if (size > 0x10000 - adr)
+        size = 0x10000 - adr;
+    memcpy(emu->mem + adr, data, size);
+    emu_mark_dirty(emu, adr, size);
+    if (data_mode) {
+        emu->mem[0] = size & 0xFF;
+        emu->mem[1] = size >> 8;
+        emu_mark_dirty(emu, 0, 2);
+    }
+    emu->a = emu->x = emu->y = 0;
+    emu->sp = 0xFF;
+    emu->sr = 1 << 5;
+    emu->pc = entry;
+
+    uint64_t total = 0;
+    abs_t prev = 0;
+    while (total < max_cycles) {
+        abs_t pc = emu->pc;
+        uint16_t edge = (prev >> 1) ^ pc;
+        // counters wrap from 255 to 1, so an edge that was hit never reads as 0
+        fuzz_edges[edge] += 1 + (fuzz_edges[edge] == 0xFF);
+#ifdef FUZZ_AFL
+        __afl_area_ptr[edge] += 1 + (__afl_area_ptr[edge] == 0xFF);
+#endif
+        prev = pc;
+        if (pc == crash_adr)
+            abort();
+        uint8_t opcode = ADDR(emu, pc);
+        const instr_info* i = instr_map[opcode];
+        if (i == NULL || opcode == 0x00)
+            break;
+        emu->pc++;
+        total += i->exec(emu);
+    }
+    return 0;
+}
+
+#ifndef FUZZ_LIBFUZZER
+
+#ifdef FUZZ_AFL
+__AFL_FUZZ_INIT();
+
+int main(int argc, char** argv) {
+    LLVMFuzzerInitialize(&argc, &argv);
+    __AFL_INIT();
+    uint8_t* buf = __AFL_FUZZ_TESTCASE_BUF;
+    while (__AFL_LOOP(100000))
+        LLVMFuzzerTestOneInput(buf, __AFL_FUZZ_TESTCASE_LEN);
+    return 0;
+}
+#else
+static uint8_t input[0x10000];
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char** argv) {
+    long runs = 1;
+    int first = 1;
+    if (argc > 2 && strcmp(argv[1], "-n") == 0) {
+        runs = atol(argv[2]);
+        first = 3;
+    }
+    if (first >= argc) {
+        printf("Usage: %s [-n runs] input...\n", argv[0]);
+        return 2;
+    }
+    LLVMFuzzerInitialize(&argc, &argv);
+
+    long execs = 0;
+    double t0 = now_s();
+    for (int k = first; k < argc; k++) {
+        FILE* f = fopen(argv[k], "rb");
+        if (f == NULL) {
+            perror(argv[k]);
+            return 2;
+        }
+        size_t size = fread(input, 1, sizeof(input), f);
+        fclose(f);
+        for (long r = 0; r < runs; r++)
+            LLVMFuzzerTestOneInput(input, size);
+        execs += runs;
+    }
+    double t = now_s() - t0;
+
+    int hit = 0;
+    for (int k = 0; k < FUZZ_MAP_SIZE; k++)
+        hit += fuzz_edges[k] != 0;
+    printf("%ld executions in %.3fs, %.0f/s, %d edges hit\n", execs, t, execs / t, hit);
+    return 0;
+}
+#endif
+
+#endif
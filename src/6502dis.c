@@ -0,0 +1,83 @@
+#include "disasm.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/*
+Disassembles an image (default) or a trace written by bin/6502emu -t, from stdin to stdout.
+Input is read and output written in large blocks, the listing is formatted straight into the
+output buffer.
+*/
+
+#define IN_SIZE (1 << 20)
+#define OUT_SIZE (8 << 20)
+
+static uint8_t in[IN_SIZE];
+static char out[OUT_SIZE];
+
+static int write_all(const char* buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(STDOUT_FILENO, buf, len);
+        if (n <= 0) {
+            perror("write");
+            return -1;
+        }
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    int trace = 0;
+    abs_t base = 0x4000;
+    int opt;
+    while ((opt = getopt(argc, argv, "tb:")) != -1) {
+        switch (opt) {
+            case 't':
+                trace = 1;
+                break;
+            case 'b': //address of the first byte of the image, hex
+                base = strtoul(optarg, NULL, 16);
+                break;
+            default:
+                printf("Usage: %s [-b base_adr] < image.bin\n       %s -t < trace.bin\n", argv[0], argv[0]);
+                return 2;
+        }
+    }
+
+    size_t have = 0; //bytes in the buffer, left over from the last block plus newly read
+    int eof = 0;
+    while (!eof || have > 0) {
+        while (!eof && have < IN_SIZE) {
+            ssize_t n = read(STDIN_FILENO, in + have, IN_SIZE - have);
+            if (n < 0) {
+                perror("read");
+                return 1;
+            }
+            if (n == 0)
+                eof = 1;
+            have += n;
+        }
+
+        size_t used, len;
+        if (trace)
+            len = disasm_trace(in, have, out, OUT_SIZE, &used);
+        else
+            len = disasm_image(in, have, base, eof, out, OUT_SIZE, &used);
+        if (write_all(out, len))
+            return 1;
+        if (used == 0) {
+            if (trace && eof && have > 0)
+                fprintf(stderr, "%zu trailing bytes are not a whole trace record\n", have);
+            break;
+        }
+
+        base += used;
+        memmove(in, in + used, have - used);
+        have -= used;
+    }
+    return 0;
+}
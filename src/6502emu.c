@@ -1,97 +1,337 @@
+#include "addr_idx.h"
+#include "analysis.h"
+#include "asm.h"
+#include "debug_server.h"
+#include "difftest.h"
 #include "emustate.h"
 #include "instructions.h"
 #include "instr_map.h"
+#include "job.h"
+#include "job_server.h"
+#include "lib6502emu.h"
+#include "predecode.h"
 #include "types.h"
 
+#include <signal.h>
 #include <time.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
+static emustate* running; //for the SIGINT handler
+
+static void on_interrupt(int sig) {
+    emu_request_stop(running);
+}
+
+static volatile sig_atomic_t stop_serving;
+
+static void on_stop_serving(int sig) {
+    stop_serving = 1;
+}
+
 /*
-Read 8 bit value in memory stored at current program counter, and increment program counter
+serve jobs on a Unix socket until SIGINT or SIGTERM
 */
-uint8_t read_8(emustate* emu) {
-    uint8_t v = emu->memory[emu->pc/256][emu->pc%256];
-    emu->pc++; //this is done because trying to do it in one line may use undefined behavior
-    return v;
+static int run_job_server(const char* path, int n_workers) {
+    job_server* srv = job_server_start(path, n_workers);
+    if (srv == NULL) {
+        perror(path);
+        return 2;
+    }
+    signal(SIGINT, on_stop_serving);
+    signal(SIGTERM, on_stop_serving);
+    printf("Serving jobs on %s with %d workers\n", path, n_workers);
+    fflush(stdout);
+    while (!stop_serving)
+        sleep(1);
+    job_server_stop(srv);
+    return 0;
 }
 
 /*
-Read 16 bit value in memory stored at current program counter and PC+1, and increment program counter 
+run job records from stdin until it ends, writing a result record for each to stdout
 */
-uint16_t read_16(emustate* emu) {
-    return read_8(emu) | (read_8(emu) << 8);
+static int run_job_stream(void) {
+    emustate* emu = emu_create();
+    if (emu == NULL) {
+        fprintf(stderr, "Failed to allocate emulator\n");
+        return 2;
+    }
+    emu_track_dirty(emu, 1);
+    int ret = job_serve(emu, STDIN_FILENO, STDOUT_FILENO, NULL);
+    emu_destroy(emu);
+    if (ret != 0) {
+        fprintf(stderr, "Job stream ended in the middle of a record, or could not be written\n");
+        return 2;
+    }
+    return 0;
 }
 
-void reset_proc(emustate* emu) {
-    emu->a=0;
-    emu->pc=0;
-    emu->sp=0xFF;
-    emu->sr=(1 << 5); //bit 5 should always be set
-    emu->x=0;
-    emu->y=0;
-    for (int i = 0; i < 256; i++) {
-        for (int j = 0; j < 256; j++) {
-            emu->memory[i][j] = 0;
+/*
+run the program at full speed through the predecoded dispatch, without tracing or sleeping
+uint64_t max_cycles: cycle budget
+int stop_mask: STOP_* reasons to return on, Ctrl-C always stops
+const char* debug_path: Unix socket to serve the debugger line protocol on while running, or NULL
+*/
+static int run_fast(emustate* emu, uint64_t max_cycles, int stop_mask, const char* debug_path) {
+    emu->cache = decode_cache_create();
+    if (emu->cache == NULL) {
+        printf("Failed to allocate decode cache\n");
+        return 2;
+    }
+    // decode everything reachable from the vectors and the start address before the clock starts
+    code_map* map = code_map_create();
+    if (map != NULL && code_map_build_vectors(map, emu, &emu->pc, 1) == 0)
+        code_map_prewarm(map, emu, emu->cache);
+    code_map_free(map);
+
+    debug_server* srv = NULL;
+    if (debug_path != NULL && (srv = debug_server_start(debug_path, emu)) == NULL) {
+        perror(debug_path);
+        return 2;
+    }
+    running = emu;
+    signal(SIGINT, on_interrupt);
+    int stop = emu_run_until(emu, max_cycles, stop_mask | STOP_HOST);
+    signal(SIGINT, SIG_DFL);
+    debug_server_stop(srv);
+
+    if (stop & STOP_INVALID)
+        printf("Invalid opcode $%02x\n", emu_read(emu, emu->pc));
+    if (stop & STOP_BREAKPOINT)
+        printf("Breakpoint\n");
+    if (stop & STOP_WATCH)
+        printf("Access to watched address $%04x\n", emu->watch_hit);
+    if (stop & STOP_BRK)
+        printf("BRK\n");
+    if (stop & STOP_HOST)
+        printf("Interrupted\n");
+    if (stop & STOP_CYCLES)
+        printf("Cycle limit reached\n");
+    printf(" @ $%04x after %llu cycles  A=$%02x X=$%02x Y=$%02x SR=$%02x SP=$%02x\n", emu->pc, (unsigned long long)emu->cycles,
+        emu->a, emu->x, emu->y, emu->sr, emu->sp);
+
+    decode_cache_free(emu->cache);
+    emu->cache = NULL;
+    return (stop & STOP_INVALID) ? 1 : 0;
+}
+
+static int write_profile(const pair_profile* profile, const char* path) {
+    FILE* f = fopen(path, "w");
+    if (f == NULL) {
+        perror(path);
+        return 2;
+    }
+    pair_profile_write(profile, f, 64);
+    fclose(f);
+    return 0;
+}
+
+/*
+run the program at full speed on the interpreter, an instruction at a time, recording the opcode
+pairs it executes. Fusion would hide the pairs, so there is no predecoded dispatch
+uint64_t max_cycles: cycle budget
+int stop_brk: non-zero to return after a BRK instruction, Ctrl-C always stops
+*/
+static int run_profile(emustate* emu, uint64_t max_cycles, int stop_brk, const char* profile_path) {
+    static pair_profile profile;
+    pair_profile_reset(&profile);
+    running = emu;
+    signal(SIGINT, on_interrupt);
+    uint64_t start = emu->cycles;
+    const char* stop = "Cycle limit reached";
+    while (emu->cycles - start < max_cycles) {
+        if (atomic_exchange(&emu->host_stop, 0)) {
+            stop = "Interrupted";
+            break;
+        }
+        uint8_t opcode = emu_read(emu, emu->pc);
+        if (emu_step(emu) == 0) {
+            printf("Invalid opcode $%02x\n", opcode);
+            stop = NULL;
+            break;
         }
-    }   
+        pair_profile_record(&profile, opcode);
+        if (stop_brk && opcode == 0x00) {
+            stop = "BRK";
+            break;
+        }
+    }
+    signal(SIGINT, SIG_DFL);
+    if (stop != NULL)
+        printf("%s\n", stop);
+    printf(" @ $%04x after %llu cycles\n", emu->pc, (unsigned long long)emu->cycles);
+    if (write_profile(&profile, profile_path) != 0)
+        return 2;
+    return stop == NULL ? 1 : 0;
+}
+
+/*
+run the program on the interpreter and the predecoded dispatch (or the bus core) in lockstep and report where they disagree
+*/
+static int run_diff(const emustate* emu, uint64_t max_cycles, int bus) {
+    diff_result res;
+    int d = diff_run(emu, diff_step_interp, bus ? diff_step_bus : diff_step_predecode, max_cycles, &res);
+    if (d < 0) {
+        printf("Failed to allocate emulator\n");
+        return 2;
+    }
+    diff_print(stdout, &res);
+    diff_result_free(&res);
+    return d;
 }
 
 int main(int argc, char** argv) {
-    
-    emustate emu;
-    reset_proc(&emu);
+    static emustate emu;
+    emu_init(&emu);
+
+    int fast = 0;
+    int diff = 0;
+    int bus = 0;
+    int assemble = 0;
+    uint64_t max_cycles = UINT64_MAX;
+    int stop_mask = 0;
+    const char* profile_path = NULL;
+    const char* debug_path = NULL;
+    const char* job_path = NULL;
+    int n_workers = 4;
+    FILE* trace = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "afdBp:t:c:b:w:r:sg:j:n:")) != -1) {
+        switch (opt) {
+            case 'a': //stdin is assembly source instead of a binary
+                assemble = 1;
+                break;
+            case 'f':
+                fast = 1;
+                break;
+            case 'd': //differential run, interpreter against the predecoded dispatch
+                diff = 1;
+                break;
+            case 'B': //cycle-stepped bus core, for -f and -d
+                bus = 1;
+                break;
+            case 'p': //write opcode pair profile, in fusion.def format. With -f only -c and -s apply
+                profile_path = optarg;
+                break;
+            case 't': //write a trace of every executed instruction, for bin/6502dis -t
+                trace = fopen(optarg, "wb");
+                if (trace == NULL) {
+                    perror(optarg);
+                    return 2;
+                }
+                break;
+            case 'c': //applies to -f and -d, the options below only to -f
+                max_cycles = strtoull(optarg, NULL, 0);
+                break;
+            case 'b': //addresses are hex, e.g. -b 4010
+                emu_set_breakpoint(&emu, strtoul(optarg, NULL, 16), 1);
+                stop_mask |= STOP_BREAKPOINT;
+                break;
+            case 'w': //watch writes, -r reads
+            case 'r': {
+                abs_t adr = strtoul(optarg, NULL, 16);
+                int kinds = (BITMAP_TEST(emu.watch, adr) ? WATCH_WRITE : 0) | (BITMAP_TEST(emu.read_watch, adr) ? WATCH_READ : 0);
+                emu_set_watch(&emu, adr, kinds | (opt == 'w' ? WATCH_WRITE : WATCH_READ));
+                stop_mask |= STOP_WATCH;
+                break;
+            }
+            case 's':
+                stop_mask |= STOP_BRK;
+                break;
+            case 'g': //debugger server on a Unix socket, see debug_server.h for the protocol
+                debug_path = optarg;
+                break;
+            case 'j': //job server on a Unix socket, or job records on stdin and results on stdout for "-", see job.h
+                job_path = optarg;
+                break;
+            case 'n': //job server workers
+                n_workers = atoi(optarg);
+                break;
+            default:
+                printf("Usage: %s [-a] [-B] [-p pair_profile.txt] [-t trace.bin] [-f [-c max_cycles] [-b break_adr]... [-w watch_adr]... [-r watch_adr]... [-s] [-g debug.sock]] [-d [-c max_cycles]] < program.bin|program.asm\n"
+                    "       %s -j jobs.sock|- [-n workers]\n", argv[0], argv[0]);
+                return 2;
+        }
+    }
+
+    if (job_path != NULL && strcmp(job_path, "-") == 0)
+        return run_job_stream();
+    if (job_path != NULL)
+        return run_job_server(job_path, n_workers);
+
+    static pair_profile profile;
+    pair_profile_reset(&profile);
+
     int clockspeed = 1000000; //1Mhz
-    abs_t adr = 0x4000;
-    uint8_t byte;
-    while (read(STDIN_FILENO, &byte, 1) > 0) { //read program from stdin , starting at mem address 0x4000
-        emu.memory[adr/256][adr%256] = byte;
-        adr++;
+    if (assemble) {
+        static char source[0x40000];
+        ssize_t n, len = 0;
+        while (len < sizeof(source)-1 && (n = read(STDIN_FILENO, source+len, sizeof(source)-1-len)) > 0)
+            len += n;
+        source[len] = 0;
+        asm_result res;
+        if (asm_assemble(&emu, source, 0x4000, &res) != 0) {
+            printf("line %d: %s\n", res.error_line, res.error);
+            return 2;
+        }
+        printf("Assembled %d program bytes into memory at $%04x\n", res.size, res.start);
+        emu.pc = res.start; //set program counter to beginning of program in memory
+    } else {
+        abs_t adr = 0x4000;
+        uint8_t byte;
+        while (read(STDIN_FILENO, &byte, 1) > 0) { //read program from stdin , starting at mem address 0x4000
+            emu_write(&emu, adr, byte);
+            adr++;
+        }
+        printf("Read %d program bytes into memory\n", adr-0x4000);
+        emu.pc = 0x4000; //set program counter to beginning of program in memory
     }
-    printf("Read %d program bytes into memory\n", adr-0x4000);
+    if (diff)
+        return run_diff(&emu, max_cycles, bus);
+    if (fast && bus && emu_set_core(&emu, EMU_CORE_BUS) != 0) {
+        printf("Failed to allocate bus core\n");
+        return 2;
+    }
+    if (fast && profile_path != NULL)
+        return run_profile(&emu, max_cycles, stop_mask & STOP_BRK, profile_path);
+    if (fast)
+        return run_fast(&emu, max_cycles, stop_mask, debug_path);
 
-    emu.pc = 0x4000; //set program counter to beginning of program in memory
     while (1) {
         uint8_t opcode = read_8(&emu);
         const instr_info* i = instr_map[opcode];
+        if (trace != NULL) { //address, then the instruction bytes
+            abs_t adr = emu.pc-1;
+            uint8_t record[5] = {adr%256, adr/256};
+            int len = i == NULL ? 1 : i->length;
+            for (int k = 0; k < len; k++)
+                record[2+k] = emu_read(&emu, adr+k);
+            fwrite(record, 1, 2+len, trace);
+        }
         if (i == NULL) {
             printf("Invalid opcode $%02x\n @ $%04x\n", opcode, emu.pc-1);
+            if (profile_path != NULL && write_profile(&profile, profile_path) != 0)
+                return 2;
+            if (trace != NULL)
+                fclose(trace);
             return 1;
         }
+        pair_profile_record(&profile, opcode);
         if (opcode != i->opcode) {
             printf("Opcode in memory ($%02x) at address $%04x and opcode in lookup table (%s, $%02x) do not match\n", opcode, emu.pc-1, i->name, i->opcode);
             return 1;
         }
         printf("Decoded instruction %s ($%02x) @ $%04x\n", i->name, opcode, emu.pc-1);
-        cycles_t cycles;
-        switch (i->type) {
-            case Implied:
-                cycles = i->fptr.implied(&emu);
-                break;
-            case Relative:
-                cycles = i->fptr.relative(&emu, read_8(&emu));
-                break;
-            case Zeropage:
-                cycles = i->fptr.zpg(&emu, read_8(&emu));
-                break;
-            case Absolute:
-                cycles = i->fptr.absolute(&emu, read_16(&emu));
-                break;
-            case Immediate:
-                cycles = i->fptr.immediate(&emu, read_8(&emu));
-                break;
-            case Indirect:
-                cycles = i->fptr.indirect(&emu, read_16(&emu));
-                break;
-            default:
-                printf("Failed to determine instruction type\n");
-                return 2;
-        }
+        cycles_t cycles = i->exec(&emu);
         
         //TODO sleep with cycles
         int sleep_time = ((float)cycles/clockspeed)*1000000; //determine time for cycles to occur, convert to microseconds
         printf("%s ($%02x) took %d cycles to execute\n", i->name, opcode, cycles);
-        usleep(sleep_time);
+        if (profile_path == NULL && trace == NULL) //profiling and tracing want the program to finish, not to run in real time
+            usleep(sleep_time);
     }
 
     return 0;
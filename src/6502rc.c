@@ -0,0 +1,81 @@
+#include "analysis.h"
+#include "asm.h"
+#include "lib6502emu.h"
+#include "recomp.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/*
+Recompiles a ROM image (or assembly source with -a) from stdin to C on stdout, see recomp.h.
+Blocks are found from the NMI/reset/IRQ vectors and the entry points given with -e.
+*/
+
+#define MAX_ENTRIES 256
+
+int main(int argc, char** argv) {
+    static emustate emu;
+    emu_init(&emu);
+
+    int assemble = 0;
+    long base = -1;
+    const char* name = "rom";
+    abs_t entries[MAX_ENTRIES];
+    int n_entries = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "ab:e:n:")) != -1) {
+        switch (opt) {
+            case 'a': //stdin is assembly source instead of a binary
+                assemble = 1;
+                break;
+            case 'b': //load address of the image, hex. By default the image ends at $ffff
+                base = strtoul(optarg, NULL, 16);
+                break;
+            case 'e': //entry point, hex
+                if (n_entries == MAX_ENTRIES) {
+                    printf("Too many entry points\n");
+                    return 2;
+                }
+                entries[n_entries++] = strtoul(optarg, NULL, 16);
+                break;
+            case 'n': //name of the recomp_image in the generated file
+                name = optarg;
+                break;
+            default:
+                printf("Usage: %s [-a] [-b base_adr] [-e entry_adr]... [-n image_name] < rom.bin > rom.c\n", argv[0]);
+                return 2;
+        }
+    }
+
+    static char input[0x40000];
+    size_t len = 0;
+    ssize_t n;
+    while (len < sizeof(input)-1 && (n = read(STDIN_FILENO, input+len, sizeof(input)-1-len)) > 0)
+        len += n;
+    if (assemble) {
+        input[len] = 0;
+        asm_result res;
+        if (asm_assemble(&emu, input, base < 0 ? 0x4000 : base, &res) != 0) {
+            fprintf(stderr, "line %d: %s\n", res.error_line, res.error);
+            return 2;
+        }
+    } else {
+        if (len > 0x10000) {
+            fprintf(stderr, "Image is larger than 64K\n");
+            return 2;
+        }
+        emu_load(&emu, base < 0 ? 0x10000 - len : base, (const uint8_t*)input, len);
+    }
+
+    code_map* map = code_map_create();
+    if (map == NULL || code_map_build_vectors(map, &emu, entries, n_entries) != 0) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    if (map->conflicts)
+        fprintf(stderr, "warning: %d bytes are both opcode and operand\n", map->conflicts);
+    int r = recomp_generate(stdout, &emu, map, name);
+    code_map_free(map);
+    return r == 0 ? 0 : 1;
+}
@@ -4,32 +4,133 @@
 #include "types.h"
 #include "emustate.h"
 
-#define ADDR(e,x) e->memory[(x)/256][(x)%256]
-#define ZPG(e,x) e->memory[0][(x)%256]
-#define BRANCH_CYCLES(e,offset) (e->pc/256 != (e->pc+offset)/256 ? 2 : 1)
+/*
+Addressing helpers. These run on every memory operand, so they are all inline and branch-free:
+memory is accessed through the flat 64K view (emustate.mem), and page crossings are detected by
+XORing the two addresses, since two addresses are on the same page iff their high bytes match.
+*/
+
+#define ADDR(e,x) ((e)->mem[(abs_t)(x)])
+#define ZPG(e,x) ((e)->mem[(zpg_t)(x)])
+// 1 if a and b are on different pages, 0 otherwise
+#define PAGE_CROSSED(a,b) ((abs_t)((a) ^ (b)) > 0xFF)
+#define BRANCH_CYCLES(e,offset) (1 + PAGE_CROSSED((e)->pc, (e)->pc+(offset)))
+
+/*
+Read 8 bit value in memory stored at current program counter, and increment program counter
+*/
+static inline uint8_t read_8(emustate* emu) {
+    return ADDR(emu, emu->pc++);
+}
+
+/*
+Read 16 bit value in memory stored at current program counter and PC+1, and increment program counter 
+*/
+static inline uint16_t read_16(emustate* emu) {
+    uint16_t v = ADDR(emu, emu->pc) | (ADDR(emu, emu->pc+1) << 8);
+    emu->pc += 2;
+    return v;
+}
+
+/*
+emustate* emu: the emulator/processor state
+abs_t adr: address an instruction just wrote to
+runs the write hooks in emu->write_hooks, e.g. raises STOP_WATCH if adr is watched. Every write
+made by an instruction goes through here, and costs one test while no hook is set
+*/
+static inline void mem_written(emustate* emu, abs_t adr) {
+    int hooks = emu->write_hooks;
+    if (hooks == 0)
+        return;
+    if ((hooks & HOOK_WATCH) && (emu->page_flags[adr >> 8] & PAGE_WATCH_W) && BITMAP_TEST(emu->watch, adr)) {
+        emu->watch_hit = adr;
+        emu_raise(emu, STOP_WATCH);
+    }
+    if (hooks & HOOK_HASH) //FNV-1a over (address, value) in write order
+        emu->write_hash = (emu->write_hash ^ ((uint32_t)adr << 8 | ADDR(emu, adr))) * 0x100000001b3ull;
+    if (hooks & HOOK_DIRTY)
+        emu->dirty[adr >> 11] |= 1 << ((adr >> 8) & 7);
+    if ((hooks & HOOK_LOG) && BITMAP_TEST(emu->shared, adr >> 8) && emu->log_len < emu->log_cap)
+        emu->write_log[emu->log_len++] = (uint32_t)adr << 8 | ADDR(emu, adr);
+}
+
+/*
+write value to memory at adr on behalf of an instruction
+*/
+static inline void mem_write(emustate* emu, abs_t adr, uint8_t value) {
+    ADDR(emu, adr) = value;
+    mem_written(emu, adr);
+}
+
+/*
+emustate* emu: the emulator/processor state
+abs_t adr: address an instruction is about to read data from
+raises STOP_WATCH if adr is read-watched. Every data read made by an instruction (operands, pointers,
+the stack) goes through here; for pages without a watch it costs one test of page_flags
+*/
+static inline void mem_reading(emustate* emu, abs_t adr) {
+    if ((emu->page_flags[adr >> 8] & PAGE_WATCH_R) && BITMAP_TEST(emu->read_watch, adr)) {
+        emu->watch_hit = adr;
+        emu_raise(emu, STOP_WATCH);
+    }
+}
+
+/*
+read data from memory at adr on behalf of an instruction
+*/
+static inline uint8_t mem_read(emustate* emu, abs_t adr) {
+    mem_reading(emu, adr);
+    return ADDR(emu, adr);
+}
+
+/*
+push value onto the stack (page 1)
+*/
+static inline void push_8(emustate* emu, uint8_t value) {
+    mem_write(emu, 0x100 | emu->sp--, value);
+}
+
+/*
+return: value pulled from the stack (page 1)
+*/
+static inline uint8_t pull_8(emustate* emu) {
+    return mem_read(emu, 0x100 | ++emu->sp);
+}
 
 /*
 emustate* emu: the emulator/processor state
-indr_t opr: address to index to find new address
-return: 16-bit address stored at address opr
+indr_t opr: zero-page address to index by X to find the pointer (wraps around within the zero page)
+return: 16-bit address stored at address opr+X
 */
-abs_t u_fetch_indr_x(emustate* emu, indr_t opr);
+static inline abs_t u_fetch_indr_x(emustate* emu, indr_t opr) {
+    zpg_t ptr = opr + emu->x;
+    return mem_read(emu, ptr) | (mem_read(emu, (zpg_t)(ptr+1)) << 8);
+}
 
 /*
 emustate* emu: the emulator/processor state
-indr_t opr: address to index to find new address
-cycles_t* cycle_count: pointer to cycles_t which will include the extra # of cycles if a page boundary is crossed. (May be NULL)
-return: 16-bit address stored at address opr
+indr_t opr: zero-page address of the pointer (wraps around within the zero page)
+cycles_t* cycle_count: set to the extra # of cycles, 1 if adding Y to the pointer crosses a page boundary, 0 otherwise
+return: 16-bit address stored at address opr, plus Y
 */
-abs_t u_fetch_indr_y(emustate* emu, indr_t opr, cycles_t* cycle_count);
+static inline abs_t u_fetch_indr_y(emustate* emu, indr_t opr, cycles_t* cycle_count) {
+    abs_t base = mem_read(emu, (zpg_t)opr) | (mem_read(emu, (zpg_t)(opr+1)) << 8);
+    abs_t adr = base + emu->y;
+    *cycle_count = PAGE_CROSSED(base, adr);
+    return adr;
+}
 
 /*
 emustate* emu: the emulator/processor state
 uint8_t reg: the value of the register that will be used to index (e.g, X or Y)
 abs_t opr: memory address to access
-cycles_t* cycle_count: pointer to cycles_t which will include the extra # of cycles if a page boundary is crossed. (May be NULL)
+cycles_t* cycle_count: set to the extra # of cycles, 1 if opr+reg is on a different page than opr, 0 otherwise
 return: the value stored at 16-bit address opr+reg
 */
-uint8_t u_fetch_abs_reg(emustate* emu, uint8_t reg, abs_t opr, cycles_t* cycle_count);
+static inline uint8_t u_fetch_abs_reg(emustate* emu, uint8_t reg, abs_t opr, cycles_t* cycle_count) {
+    abs_t adr = opr + reg;
+    *cycle_count = PAGE_CROSSED(opr, adr);
+    return mem_read(emu, adr);
+}
 
-#endif
\ No newline at end of file
+#endif
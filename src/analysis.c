@@ -0,0 +1,202 @@
+#include "analysis.h"
+#include "addr_idx.h"
+#include "instr_map.h"
+#include "predecode.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+code_map* code_map_create(void) {
+    code_map* map = malloc(sizeof(code_map));
+    if (map == NULL)
+        return NULL;
+    memset(map, 0, sizeof(code_map));
+    return map;
+}
+
+void code_map_free(code_map* map) {
+    if (map == NULL)
+        return;
+    free(map->blocks);
+    free(map);
+}
+
+static enum block_exit exit_of(const instr_info* i) {
+    if (i == NULL)
+        return EXIT_STOP;
+    if (i->mode == Rel)
+        return EXIT_BRANCH;
+    switch (i->opcode) {
+        case 0x4C: return EXIT_JUMP;     // JMP abs
+        case 0x6C: return EXIT_INDIRECT; // JMP (ind)
+        case 0x20: return EXIT_CALL;     // JSR abs
+        case 0x40: return EXIT_RETURN;   // RTI
+        case 0x60: return EXIT_RETURN;   // RTS
+        case 0x00: return EXIT_STOP;     // BRK
+    }
+    return EXIT_FALL;
+}
+
+/*
+branch/jump/call target of the instruction at adr
+*/
+static abs_t target_of(const emustate* emu, const instr_info* i, abs_t adr) {
+    if (i->mode == Rel)
+        return adr + 2 + (rel_t)ADDR(emu, adr+1);
+    return ADDR(emu, adr+1) | (ADDR(emu, adr+2) << 8);
+}
+
+typedef struct worklist {
+    abs_t* adr;
+    int n;
+} worklist;
+
+/*
+mark adr as the start of a block, and queue it to be walked if it was not already
+*/
+static void push(code_map* map, worklist* work, abs_t adr) {
+    if (!map->leader[adr]) {
+        map->leader[adr] = 1;
+        work->adr[work->n++] = adr;
+    }
+}
+
+/*
+follow straight-line code from adr, marking bytes and queueing the targets of control flow
+*/
+static void walk(code_map* map, worklist* work, const emustate* emu, abs_t adr) {
+    for (;;) {
+        if (map->kind[adr] == MAP_OPCODE) { //joined code that was already walked, paths meet so a block starts here
+            map->leader[adr] = 1;
+            return;
+        }
+        if (map->kind[adr] == MAP_OPERAND) {
+            map->conflicts++;
+            return;
+        }
+        map->kind[adr] = MAP_OPCODE;
+        const instr_info* i = instr_map[ADDR(emu, adr)];
+        if (i == NULL)
+            return;
+        for (int k = 1; k < i->length; k++) {
+            abs_t b = adr + k;
+            if (map->kind[b] == MAP_DATA)
+                map->kind[b] = MAP_OPERAND;
+            else
+                map->conflicts++;
+        }
+
+        abs_t next = adr + i->length;
+        switch (exit_of(i)) {
+            case EXIT_BRANCH:
+            case EXIT_CALL:
+                push(map, work, target_of(emu, i, adr));
+                push(map, work, next);
+                return;
+            case EXIT_JUMP:
+                push(map, work, target_of(emu, i, adr));
+                return;
+            case EXIT_FALL:
+                if (next < adr) { //wrapped around the end of memory, start a new block at $0000
+                    push(map, work, next);
+                    return;
+                }
+                adr = next;
+                break;
+            default:
+                return;
+        }
+    }
+}
+
+/*
+the block starting at adr, which must be a leader
+*/
+static basic_block make_block(const code_map* map, const emustate* emu, abs_t adr) {
+    basic_block b = {.start = adr, .next = -1, .target = -1};
+    for (;;) {
+        const instr_info* i = instr_map[ADDR(emu, adr)];
+        abs_t next = adr + (i == NULL ? 1 : i->length);
+        b.exit = exit_of(i);
+        b.last = adr;
+        b.len = next - b.start;
+        if (b.exit == EXIT_BRANCH || b.exit == EXIT_JUMP || b.exit == EXIT_CALL)
+            b.target = target_of(emu, i, adr);
+        if (b.exit == EXIT_BRANCH || b.exit == EXIT_CALL)
+            b.next = next;
+        if (b.exit != EXIT_FALL)
+            return b;
+        if (map->kind[next] != MAP_OPCODE) { //runs into the operand of other code
+            b.exit = EXIT_STOP;
+            return b;
+        }
+        if (map->leader[next]) {
+            b.next = next;
+            return b;
+        }
+        adr = next;
+    }
+}
+
+int code_map_build(code_map* map, const emustate* emu, const abs_t* entries, int n_entries) {
+    free(map->blocks);
+    memset(map, 0, sizeof(code_map));
+
+    // every address is queued at most once, entries included
+    worklist work = {malloc(0x10000 * sizeof(abs_t)), 0};
+    if (work.adr == NULL)
+        return -1;
+    for (int k = 0; k < n_entries; k++)
+        push(map, &work, entries[k]);
+    while (work.n > 0)
+        walk(map, &work, emu, work.adr[--work.n]);
+    free(work.adr);
+
+    // a leader can be left pointing into the operand of other code, it does not start a block
+    int n = 0;
+    for (uint32_t adr = 0; adr < 0x10000; adr++) {
+        if (map->leader[adr] && map->kind[adr] != MAP_OPCODE)
+            map->leader[adr] = 0;
+        n += map->leader[adr];
+    }
+    map->blocks = malloc((n ? n : 1) * sizeof(basic_block));
+    if (map->blocks == NULL)
+        return -1;
+    for (uint32_t adr = 0; adr < 0x10000; adr++) {
+        if (map->leader[adr])
+            map->blocks[map->n_blocks++] = make_block(map, emu, adr);
+    }
+    return 0;
+}
+
+int code_map_build_vectors(code_map* map, const emustate* emu, const abs_t* extra, int n_extra) {
+    abs_t entries[3 + n_extra];
+    for (int k = 0; k < 3; k++) {
+        abs_t vec = 0xFFFA + 2*k; //NMI, reset, IRQ/BRK
+        entries[k] = ADDR(emu, vec) | (ADDR(emu, vec+1) << 8);
+    }
+    for (int k = 0; k < n_extra; k++)
+        entries[3+k] = extra[k];
+    return code_map_build(map, emu, entries, 3 + n_extra);
+}
+
+int code_map_find_block(const code_map* map, abs_t adr) {
+    int lo = 0, hi = map->n_blocks - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (map->blocks[mid].start == adr)
+            return mid;
+        if (map->blocks[mid].start < adr)
+            lo = mid + 1;
+        else
+            hi = mid - 1;
+    }
+    return -1;
+}
+
+void code_map_prewarm(const code_map* map, const emustate* emu, struct decode_cache* cache) {
+    for (uint32_t adr = 0; adr < 0x10000; adr++) {
+        if (map->kind[adr] == MAP_OPCODE)
+            decode_cache_prewarm(cache, emu, adr);
+    }
+}
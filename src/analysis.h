@@ -0,0 +1,90 @@
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+#include "types.h"
+#include "emustate.h"
+
+struct decode_cache;
+
+/*
+Static analysis of a program in memory
+
+Starting from entry points (usually the reset/IRQ/NMI vectors), every instruction reachable through
+fall-through, branches, JMP and JSR is followed, using instr_map for instruction lengths. This gives
+a map of which bytes are code and which are data, and the control-flow graph as basic blocks.
+
+Indirect jumps, RTS and RTI end a path, their targets are not known statically. JSR is assumed to
+return to the following instruction.
+*/
+
+// what a byte of memory is, bytes never reached as code are data
+enum byte_kind {
+    MAP_DATA, MAP_OPCODE, MAP_OPERAND
+};
+
+// how a basic block ends
+enum block_exit {
+    EXIT_FALL,      // into the next block, which starts at a branch or jump target
+    EXIT_BRANCH,    // conditional branch: to target, or falls through to next
+    EXIT_JUMP,      // JMP abs to target
+    EXIT_CALL,      // JSR abs to target, returning to next
+    EXIT_RETURN,    // RTS or RTI
+    EXIT_INDIRECT,  // JMP (ind)
+    EXIT_STOP       // BRK, an invalid opcode, or code that overlaps other code
+};
+
+typedef struct basic_block {
+    abs_t start;
+    // address of the last instruction
+    abs_t last;
+    // number of bytes, start to the end of the last instruction
+    uint16_t len;
+    enum block_exit exit;
+    // successors, -1 if there is none: the following instruction, and the branch/jump/call target
+    int32_t next;
+    int32_t target;
+} basic_block;
+
+typedef struct code_map {
+    uint8_t kind[0x10000];
+    // non-zero for the first instruction of a basic block
+    uint8_t leader[0x10000];
+    // instructions found overlapping the operand of another instruction
+    int conflicts;
+    // basic blocks, sorted by start address
+    int n_blocks;
+    basic_block* blocks;
+} code_map;
+
+/*
+return: a new, empty map, or NULL if allocation failed
+*/
+code_map* code_map_create(void);
+
+void code_map_free(code_map* map);
+
+/*
+emustate* emu: the program to analyze, only memory is used
+const abs_t* entries: addresses execution may start at
+int n_entries: number of entries
+return: 0, or -1 if allocation failed. Any previous result in map is replaced
+*/
+int code_map_build(code_map* map, const emustate* emu, const abs_t* entries, int n_entries);
+
+/*
+code_map_build from the NMI, reset and IRQ/BRK vectors at $fffa-$ffff, plus extra entries (may be NULL if n_extra is 0)
+*/
+int code_map_build_vectors(code_map* map, const emustate* emu, const abs_t* extra, int n_extra);
+
+/*
+return: index of the block starting at adr, -1 if no block starts there
+*/
+int code_map_find_block(const code_map* map, abs_t adr);
+
+/*
+decode every instruction in the map into cache ahead of execution, so the first run of the
+program does not pay for decoding
+*/
+void code_map_prewarm(const code_map* map, const emustate* emu, struct decode_cache* cache);
+
+#endif
@@ -0,0 +1,570 @@
+#include "asm.h"
+#include "addr_idx.h"
+#include "instr_map.h"
+#include "lib6502emu.h"
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+/*
+every mnemonic/addressing mode pair in the opcode spec
+*/
+typedef struct asm_op {
+    const char* name;
+    uint8_t opcode;
+    enum addr_mode mode;
+} asm_op;
+
+static const asm_op ops[] = {
+#define OP(opc, mn, h, mode, len, cyc, page, kind, arg, flags) {#mn, opc, mode},
+#include "opcodes.def"
+#undef OP
+};
+
+typedef struct symbol {
+    char name[ASM_MAX_NAME];
+    int32_t value;
+    // last pass the symbol was defined in, 0 for an empty slot
+    int pass;
+    // its value depended on a forward reference, so using it counts as a forward reference too
+    int forward;
+} symbol;
+
+typedef struct asm_ctx {
+    emustate* emu;
+    asm_result* res;
+    // 1 sizes everything and collects symbols, 2 writes memory
+    int pass;
+    int line;
+    abs_t pc;
+    // expression being parsed, and whether it used a symbol not yet defined in this pass
+    const char* p;
+    int forward;
+    int n_symbols;
+    symbol symbols[ASM_MAX_SYMBOLS];
+} asm_ctx;
+
+static int fail(asm_ctx* ctx, const char* fmt, ...) {
+    if (ctx->res->error_line == 0) {
+        va_list args;
+        va_start(args, fmt);
+        vsnprintf(ctx->res->error, sizeof(ctx->res->error), fmt, args);
+        va_end(args);
+        ctx->res->error_line = ctx->line;
+    }
+    return -1;
+}
+
+// symbols
+
+/*
+return: the slot for name, empty (pass 0) if it is not defined
+*/
+static symbol* find_symbol(asm_ctx* ctx, const char* name, size_t len) {
+    uint32_t h = 2166136261u; //FNV-1a
+    for (size_t i = 0; i < len; i++)
+        h = (h ^ (uint8_t)name[i]) * 16777619u;
+    for (uint32_t i = 0; ; i++) {
+        symbol* s = &ctx->symbols[(h + i) % ASM_MAX_SYMBOLS];
+        if (s->pass == 0 || (strlen(s->name) == len && !memcmp(s->name, name, len)))
+            return s;
+    }
+}
+
+static int define_symbol(asm_ctx* ctx, const char* name, size_t len, int32_t value, int forward) {
+    if (len >= ASM_MAX_NAME)
+        return fail(ctx, "symbol name too long");
+    symbol* s = find_symbol(ctx, name, len);
+    if (s->pass == ctx->pass)
+        return fail(ctx, "duplicate symbol '%.*s'", (int)len, name);
+    if (s->pass == 0) {
+        // leave one slot empty so lookups of undefined names terminate
+        if (ctx->n_symbols == ASM_MAX_SYMBOLS-1)
+            return fail(ctx, "too many symbols");
+        ctx->n_symbols++;
+        memcpy(s->name, name, len);
+        s->name[len] = 0;
+    }
+    s->value = value;
+    s->pass = ctx->pass;
+    s->forward = forward;
+    return 0;
+}
+
+// expressions
+
+static int ident_start(char c) {
+    return isalpha((unsigned char)c) || c == '_';
+}
+
+static int ident_char(char c) {
+    return isalnum((unsigned char)c) || c == '_';
+}
+
+static int parse_expr(asm_ctx* ctx, int min_prec, int32_t* out);
+
+static int parse_number(asm_ctx* ctx, int base, int32_t* out) {
+    const char* start = ctx->p;
+    int32_t v = 0;
+    for (;;) {
+        int c = tolower((unsigned char)*ctx->p);
+        int d = isdigit(c) ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : 99;
+        if (d >= base)
+            break;
+        v = v*base + d;
+        ctx->p++;
+    }
+    if (ctx->p == start)
+        return fail(ctx, "bad number");
+    *out = v;
+    return 0;
+}
+
+static int parse_primary(asm_ctx* ctx, int32_t* out) {
+    char c = *ctx->p;
+    if (c == '(') {
+        ctx->p++;
+        if (parse_expr(ctx, 1, out))
+            return -1;
+        if (*ctx->p != ')')
+            return fail(ctx, "missing ')'");
+        ctx->p++;
+        return 0;
+    }
+    if (c == '$') {
+        ctx->p++;
+        return parse_number(ctx, 16, out);
+    }
+    if (c == '%') {
+        ctx->p++;
+        return parse_number(ctx, 2, out);
+    }
+    if (isdigit((unsigned char)c))
+        return parse_number(ctx, 10, out);
+    if (c == '\'') {
+        if (ctx->p[1] == 0 || ctx->p[2] != '\'')
+            return fail(ctx, "bad character constant");
+        *out = (uint8_t)ctx->p[1];
+        ctx->p += 3;
+        return 0;
+    }
+    if (c == '*') {
+        ctx->p++;
+        *out = ctx->pc;
+        return 0;
+    }
+    if (ident_start(c)) {
+        const char* name = ctx->p;
+        while (ident_char(*ctx->p))
+            ctx->p++;
+        size_t len = ctx->p - name;
+        symbol* s = len < ASM_MAX_NAME ? find_symbol(ctx, name, len) : NULL;
+        if (s == NULL || s->pass == 0) {
+            if (ctx->pass == 2)
+                return fail(ctx, "undefined symbol '%.*s'", (int)len, name);
+            ctx->forward = 1;
+            *out = 0;
+            return 0;
+        }
+        // defined further down: pass 1 does not know the value yet, pass 2 must decide the same way
+        if (s->pass < ctx->pass || s->forward)
+            ctx->forward = 1;
+        *out = s->value;
+        return 0;
+    }
+    if (c == 0)
+        return fail(ctx, "missing operand");
+    return fail(ctx, "unexpected '%c'", c);
+}
+
+static int parse_unary(asm_ctx* ctx, int32_t* out) {
+    char c = *ctx->p;
+    if (c == '-' || c == '~' || c == '<' || c == '>') {
+        ctx->p++;
+        if (parse_unary(ctx, out))
+            return -1;
+        switch (c) {
+            case '-': *out = -*out; break;
+            case '~': *out = ~*out; break;
+            case '<': *out &= 0xFF; break;
+            case '>': *out = (*out >> 8) & 0xFF; break;
+        }
+        return 0;
+    }
+    return parse_primary(ctx, out);
+}
+
+/*
+return: precedence of the binary operator at p (higher binds tighter), 0 if there is none
+*/
+static int binary_prec(const char* p, int* len) {
+    *len = 1;
+    switch (*p) {
+        case '|': return 1;
+        case '^': return 2;
+        case '&': return 3;
+        case '<': case '>':
+            *len = 2;
+            return p[1] == p[0] ? 4 : 0;
+        case '+': case '-': return 5;
+        case '*': case '/': case '%': return 6;
+    }
+    return 0;
+}
+
+static int parse_expr(asm_ctx* ctx, int min_prec, int32_t* out) {
+    if (parse_unary(ctx, out))
+        return -1;
+    for (;;) {
+        int len;
+        int prec = binary_prec(ctx->p, &len);
+        if (prec == 0 || prec < min_prec)
+            return 0;
+        char op = *ctx->p;
+        ctx->p += len;
+        int32_t rhs;
+        if (parse_expr(ctx, prec+1, &rhs))
+            return -1;
+        switch (op) {
+            case '|': *out |= rhs; break;
+            case '^': *out ^= rhs; break;
+            case '&': *out &= rhs; break;
+            case '<': *out = (uint32_t)*out << (rhs & 31); break;
+            case '>': *out >>= (rhs & 31); break;
+            case '+': *out += rhs; break;
+            case '-': *out -= rhs; break;
+            case '*': *out *= rhs; break;
+            case '/': case '%':
+                if (rhs == 0) {
+                    if (!ctx->forward)
+                        return fail(ctx, "division by zero");
+                    *out = 0;
+                } else {
+                    *out = op == '/' ? *out / rhs : *out % rhs;
+                }
+                break;
+        }
+    }
+}
+
+/*
+evaluate the whole of text, which has no whitespace
+*/
+static int eval(asm_ctx* ctx, const char* text, int32_t* out) {
+    ctx->p = text;
+    ctx->forward = 0;
+    if (parse_expr(ctx, 1, out))
+        return -1;
+    if (*ctx->p != 0)
+        return fail(ctx, "unexpected '%c'", *ctx->p);
+    return 0;
+}
+
+// output
+
+static void emit(asm_ctx* ctx, uint8_t byte) {
+    if (ctx->pass == 2) {
+        if (ctx->res->size == 0)
+            ctx->res->start = ctx->pc;
+        emu_write(ctx->emu, ctx->pc, byte);
+        ctx->res->size++;
+        ctx->res->end = ctx->pc + 1;
+    }
+    ctx->pc++;
+}
+
+/*
+remove whitespace outside of quotes, in place
+*/
+static void squeeze(char* s) {
+    char* out = s;
+    char quote = 0;
+    for (; *s; s++) {
+        if (quote) {
+            if (*s == quote)
+                quote = 0;
+        } else if (*s == '"' || *s == '\'') {
+            quote = *s;
+        } else if (isspace((unsigned char)*s)) {
+            continue;
+        }
+        *out++ = *s;
+    }
+    *out = 0;
+}
+
+/*
+split a comma separated list in place
+return: the next item, *s is left on the one after it (NULL at the end)
+*/
+static char* next_item(char** s) {
+    char* item = *s;
+    char quote = 0;
+    int depth = 0;
+    for (char* p = item; *p; p++) {
+        if (quote) {
+            if (*p == quote)
+                quote = 0;
+        } else if (*p == '"' || *p == '\'') {
+            quote = *p;
+        } else if (*p == '(') {
+            depth++;
+        } else if (*p == ')') {
+            depth--;
+        } else if (*p == ',' && depth == 0) {
+            *p = 0;
+            *s = p+1;
+            return item;
+        }
+    }
+    *s = NULL;
+    return item;
+}
+
+static int directive(asm_ctx* ctx, const char* name, char* args) {
+    squeeze(args);
+    int32_t v;
+    if (!strcasecmp(name, "org")) {
+        if (eval(ctx, args, &v))
+            return -1;
+        if (ctx->forward)
+            return fail(ctx, ".org must not refer to symbols defined later");
+        ctx->pc = v;
+        return 0;
+    }
+    int word = !strcasecmp(name, "word") || !strcasecmp(name, "dw");
+    if (!word && strcasecmp(name, "byte") && strcasecmp(name, "db"))
+        return fail(ctx, "unknown directive '.%s'", name);
+    while (args != NULL) {
+        char* item = next_item(&args);
+        size_t len = strlen(item);
+        if (!word && len >= 2 && item[0] == '"' && item[len-1] == '"') {
+            for (size_t i = 1; i < len-1; i++)
+                emit(ctx, item[i]);
+            continue;
+        }
+        if (eval(ctx, item, &v))
+            return -1;
+        if (ctx->pass == 2 && (word ? (v < -0x8000 || v > 0xFFFF) : (v < -0x80 || v > 0xFF)))
+            return fail(ctx, "value $%x does not fit in a %s", v, word ? "word" : "byte");
+        emit(ctx, v);
+        if (word)
+            emit(ctx, v >> 8);
+    }
+    return 0;
+}
+
+// instructions
+
+/*
+opcode for each addressing mode of the mnemonic, -1 where there is none
+return: 0 if the mnemonic exists
+*/
+static int find_modes(const char* mnemonic, int16_t* modes) {
+    int found = 0;
+    for (int m = 0; m < MODE_COUNT; m++)
+        modes[m] = -1;
+    for (int i = 0; i < sizeof(ops)/sizeof(ops[0]); i++) {
+        if (!strcasecmp(ops[i].name, mnemonic)) {
+            modes[ops[i].mode] = ops[i].opcode;
+            found = 1;
+        }
+    }
+    return found ? 0 : -1;
+}
+
+/*
+choose between the zero page and absolute variant of a mode
+return: the mode, MODE_COUNT if the instruction has neither
+*/
+static enum addr_mode zpg_or_abs(const int16_t* modes, enum addr_mode zpg, enum addr_mode abs, int fits) {
+    if (modes[zpg] >= 0 && (fits || modes[abs] < 0))
+        return zpg;
+    if (modes[abs] >= 0)
+        return abs;
+    return MODE_COUNT;
+}
+
+/*
+return: non-zero if s ends with suffix (case insensitive), which is then cut off
+*/
+static int cut_suffix(char* s, const char* suffix) {
+    size_t n = strlen(s), k = strlen(suffix);
+    if (n < k || strcasecmp(s + n - k, suffix))
+        return 0;
+    s[n - k] = 0;
+    return 1;
+}
+
+static int instruction(asm_ctx* ctx, const char* mnemonic, char* opr) {
+    int16_t modes[MODE_COUNT];
+    if (find_modes(mnemonic, modes))
+        return fail(ctx, "unknown instruction '%s'", mnemonic);
+    squeeze(opr);
+
+    enum addr_mode mode;
+    int32_t v = 0;
+    int evaluated = 0;
+    const char* text = opr;
+    if (*opr == 0) {
+        mode = modes[Impl] >= 0 ? Impl : Acc;
+    } else if (!strcasecmp(opr, "A") && modes[Acc] >= 0) {
+        mode = Acc;
+    } else if (*opr == '#') {
+        mode = Imd;
+        text = opr+1;
+    } else if (*opr == '(' && modes[IndX] >= 0 && cut_suffix(opr, ",X)")) {
+        mode = IndX;
+        text = opr+1;
+    } else if (*opr == '(' && modes[IndY] >= 0 && cut_suffix(opr, "),Y")) {
+        mode = IndY;
+        text = opr+1;
+    } else if (*opr == '(' && modes[Ind] >= 0 && cut_suffix(opr, ")")) {
+        mode = Ind;
+        text = opr+1;
+    } else if (modes[Rel] >= 0) {
+        mode = Rel;
+    } else {
+        int x = cut_suffix(opr, ",X");
+        int y = !x && cut_suffix(opr, ",Y");
+        if (eval(ctx, text, &v))
+            return -1;
+        evaluated = 1;
+        int fits = !ctx->forward && v >= 0 && v <= 0xFF;
+        if (x)
+            mode = zpg_or_abs(modes, ZpgX, AbsX, fits);
+        else if (y)
+            mode = zpg_or_abs(modes, ZpgY, AbsY, fits);
+        else
+            mode = zpg_or_abs(modes, Zpg, Abs, fits);
+    }
+    if (mode == MODE_COUNT || modes[mode] < 0)
+        return fail(ctx, "addressing mode not available for %s", mnemonic);
+
+    uint8_t len = mode_map[mode].operand_len;
+    if (len != 0 && !evaluated && eval(ctx, text, &v))
+        return -1;
+
+    if (ctx->pass == 2) {
+        if (mode == Rel) {
+            v -= (abs_t)(ctx->pc + 2);
+            if (v < -128 || v > 127)
+                return fail(ctx, "branch out of range (%d bytes)", v);
+        } else if (mode == Imd) {
+            if (v < -0x80 || v > 0xFF)
+                return fail(ctx, "immediate value $%x does not fit in a byte", v);
+        } else if (len == 1 && (v < 0 || v > 0xFF)) {
+            return fail(ctx, "address $%x is not in the zero page", v);
+        } else if (len == 2 && (v < 0 || v > 0xFFFF)) {
+            return fail(ctx, "address $%x out of range", v);
+        }
+    }
+
+    emit(ctx, modes[mode]);
+    if (len >= 1)
+        emit(ctx, v);
+    if (len == 2)
+        emit(ctx, v >> 8);
+    return 0;
+}
+
+/*
+assemble one line, which has had its comment removed
+*/
+static int statement(asm_ctx* ctx, char* s) {
+    while (isspace((unsigned char)*s))
+        s++;
+
+    // label: or name = expr
+    if (ident_start(*s)) {
+        char* end = s;
+        while (ident_char(*end))
+            end++;
+        char* t = end;
+        while (isspace((unsigned char)*t))
+            t++;
+        if (*t == ':') {
+            if (define_symbol(ctx, s, end - s, ctx->pc, 0))
+                return -1;
+            s = t+1;
+            while (isspace((unsigned char)*s))
+                s++;
+        } else if (*t == '=') {
+            int32_t v;
+            squeeze(t+1);
+            if (eval(ctx, t+1, &v))
+                return -1;
+            return define_symbol(ctx, s, end - s, v, ctx->forward);
+        }
+    }
+    if (*s == 0)
+        return 0;
+
+    char word[8];
+    int dot = *s == '.';
+    if (dot)
+        s++;
+    size_t n = 0;
+    while (ident_char(s[n]))
+        n++;
+    if (n == 0 || n >= sizeof(word))
+        return fail(ctx, "syntax error");
+    memcpy(word, s, n);
+    word[n] = 0;
+    if (s[n] != 0 && !isspace((unsigned char)s[n]))
+        return fail(ctx, "syntax error");
+    return dot ? directive(ctx, word, s+n) : instruction(ctx, word, s+n);
+}
+
+static int run_pass(asm_ctx* ctx, const char* source, abs_t origin) {
+    char buf[ASM_MAX_LINE];
+    ctx->pc = origin;
+    ctx->line = 0;
+    const char* p = source;
+    while (*p) {
+        const char* eol = strchr(p, '\n');
+        size_t len = eol ? (size_t)(eol - p) : strlen(p);
+        ctx->line++;
+        if (len >= sizeof(buf))
+            return fail(ctx, "line too long");
+
+        // copy without the comment
+        char quote = 0;
+        size_t n = 0;
+        for (size_t i = 0; i < len && (quote || p[i] != ';'); i++) {
+            if (quote && p[i] == quote)
+                quote = 0;
+            else if (!quote && (p[i] == '"' || p[i] == '\''))
+                quote = p[i];
+            buf[n++] = p[i];
+        }
+        buf[n] = 0;
+
+        if (statement(ctx, buf))
+            return -1;
+        p += len;
+        if (*p == '\n')
+            p++;
+    }
+    return 0;
+}
+
+int asm_assemble(emustate* emu, const char* source, abs_t origin, asm_result* res) {
+    asm_result dummy;
+    static __thread asm_ctx ctx; //symbol table is too big for the stack of small threads
+    if (res == NULL)
+        res = &dummy;
+    memset(res, 0, sizeof(*res));
+    memset(ctx.symbols, 0, sizeof(ctx.symbols));
+    ctx.emu = emu;
+    ctx.res = res;
+    ctx.n_symbols = 0;
+    for (ctx.pass = 1; ctx.pass <= 2; ctx.pass++) {
+        if (run_pass(&ctx, source, origin))
+            return -1;
+    }
+    return 0;
+}
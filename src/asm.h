@@ -0,0 +1,53 @@
+#ifndef ASM_H
+#define ASM_H
+
+#include "types.h"
+#include "emustate.h"
+
+/*
+Two-pass 6502 assembler, assembling straight into emustate.memory
+
+Syntax, one statement per line, ';' starts a comment:
+
+    label:                  define label as the current address, may be followed by a statement
+    name = expr             define a constant
+    .org expr               set the current address
+    .byte expr, "text", ... emit bytes (.db is accepted too)
+    .word expr, ...         emit little endian words (.dw is accepted too)
+    LDA #expr               any instruction in instr_map, operands written as in mode_map
+
+Mnemonics, directives, A/X/Y and hex digits are case insensitive, labels are not.
+Numbers are decimal, $hex, %binary or 'c'. Expressions may use labels, * (current address),
+parentheses, unary - ~ < (low byte) > (high byte), and the binary operators * / % + - << >> & ^ |
+with C precedence.
+
+An operand that fits in the zero page uses the zero page mode if the instruction has one, unless it
+refers to a label defined further down (whose value is unknown in the first pass), which always
+selects the absolute mode.
+*/
+
+#define ASM_MAX_SYMBOLS 1024
+#define ASM_MAX_NAME 32
+#define ASM_MAX_LINE 256
+
+typedef struct asm_result {
+    // address of the first byte written, and the address following the last one
+    abs_t start;
+    abs_t end;
+    // number of bytes written
+    int size;
+    // 0 on success, otherwise the (1-based) line of the first error and a message
+    int error_line;
+    char error[96];
+} asm_result;
+
+/*
+emustate* emu: the memory the program is written into, nothing else is changed
+const char* source: program text, lines separated by '\n'
+abs_t origin: address of the program if it does not start with .org
+asm_result* res: filled in with where the program was written, or the error. May be NULL
+return: 0 on success, -1 on error (memory may be partially written)
+*/
+int asm_assemble(emustate* emu, const char* source, abs_t origin, asm_result* res);
+
+#endif
@@ -0,0 +1,395 @@
+#include "buscore.h"
+#include "addr_idx.h"
+#include "instr_map.h"
+#include "instructions.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+
+/*
+what the bus core does for each opcode, generated from opcodes.def
+*/
+enum bus_kind {
+    K_RD, K_LD, K_ST, K_RMW, K_BR, K_CUSTOM
+};
+
+typedef struct bus_op {
+    uint8_t kind;
+    uint8_t mode;
+    // K_BR: branch if bit flag of SR equals set
+    uint8_t flag, set;
+    // K_LD/K_ST: offset of the register in emustate
+    uint8_t reg;
+    void (*rd) (emustate*, uint8_t);
+    void (*rmw) (emustate*, uint8_t*);
+} bus_op;
+
+// flag and value for each branch condition (COND_ in instructions.c)
+#define BR_cc FLAG_C, 0
+#define BR_cs FLAG_C, 1
+#define BR_ne FLAG_Z, 0
+#define BR_eq FLAG_Z, 1
+#define BR_pl FLAG_N, 0
+#define BR_mi FLAG_N, 1
+#define BR_vc FLAG_V, 0
+#define BR_vs FLAG_V, 1
+
+#define BR_OP(mode, ...)      {K_BR, mode, __VA_ARGS__}
+#define BUS_RD(mode, arg)     {K_RD, mode, .rd = arg}
+#define BUS_LD(mode, arg)     {K_LD, mode, .reg = offsetof(emustate, arg)}
+#define BUS_ST(mode, arg)     {K_ST, mode, .reg = offsetof(emustate, arg)}
+#define BUS_RMW(mode, arg)    {K_RMW, mode, .rmw = arg}
+#define BUS_BR(mode, arg)     BR_OP(mode, BR_##arg)
+#define BUS_CUSTOM(mode, arg) {K_CUSTOM, mode}
+
+static const bus_op bus_ops[256] = {
+#define OP(opc, mn, h, mode, len, cyc, page, kind, arg, flags) [opc] = BUS_##kind(mode, arg),
+#include "opcodes.def"
+#undef OP
+};
+
+/*
+cycle on which the operand is accessed, if no index crosses a page
+*/
+static const uint8_t access_cycle[MODE_COUNT] = {
+    [Imd] = 2, [Zpg] = 3, [ZpgX] = 4, [ZpgY] = 4, [Abs] = 4, [AbsX] = 4, [AbsY] = 4, [IndX] = 6, [IndY] = 5,
+};
+
+bus_core* bus_core_create(void) {
+    return calloc(1, sizeof(bus_core));
+}
+
+void bus_core_free(bus_core* bus) {
+    free(bus);
+}
+
+void bus_set_hook(emustate* emu, bus_hook_func hook, void* ctx) {
+    emu->bus->hook = hook;
+    emu->bus->hook_ctx = ctx;
+}
+
+// bus accesses, each one is one cycle
+
+/*
+read adr for the instruction itself: opcode and operand fetches, dummy reads
+*/
+static inline uint8_t fetch(emustate* emu, bus_core* b, abs_t adr, int kind) {
+    uint8_t v = ADDR(emu, adr);
+    if (b->hook != NULL)
+        b->hook(emu, adr, v, kind, b->hook_ctx);
+    return v;
+}
+
+/*
+read data (operands, pointers, the stack) through mem_read, as the instruction core does
+*/
+static inline uint8_t load(emustate* emu, bus_core* b, abs_t adr) {
+    uint8_t v = mem_read(emu, adr);
+    if (b->hook != NULL)
+        b->hook(emu, adr, v, 0, b->hook_ctx);
+    return v;
+}
+
+static inline void store(emustate* emu, bus_core* b, abs_t adr, uint8_t value) {
+    mem_write(emu, adr, value);
+    if (b->hook != NULL)
+        b->hook(emu, adr, value, BUS_WRITE, b->hook_ctx);
+}
+
+/*
+the first write of a read-modify-write instruction, which writes back the value it read
+*/
+static inline void store_dummy(emustate* emu, bus_core* b, abs_t adr, uint8_t value) {
+    ADDR(emu, adr) = value;
+    if (b->hook != NULL)
+        b->hook(emu, adr, value, BUS_WRITE | BUS_DUMMY, b->hook_ctx);
+}
+
+// instructions
+
+static inline uint8_t* reg(emustate* emu, const bus_op* op) {
+    return (uint8_t*)emu + op->reg;
+}
+
+/*
+the cycles after the opcode fetch of instructions with a memory operand (K_RD, K_LD, K_ST, K_RMW)
+return: non-zero on the last cycle
+*/
+static int memory_cycle(emustate* emu, bus_core* b, const bus_op* op) {
+    int t = b->t;
+    int reads = op->kind == K_RD || op->kind == K_LD;
+    if (t < b->start) {
+        // forming the address
+        switch (op->mode) {
+            case Zpg:
+                b->adr = fetch(emu, b, emu->pc++, 0);
+                break;
+            case ZpgX:
+            case ZpgY:
+                if (t == 2) {
+                    b->base = fetch(emu, b, emu->pc++, 0);
+                } else {
+                    fetch(emu, b, b->base, BUS_DUMMY);
+                    b->adr = (zpg_t)(b->base + (op->mode == ZpgX ? emu->x : emu->y));
+                }
+                break;
+            case Abs:
+            case AbsX:
+            case AbsY:
+                if (t == 2) {
+                    b->base = fetch(emu, b, emu->pc++, 0);
+                } else if (t == 3) {
+                    b->base |= fetch(emu, b, emu->pc++, 0) << 8;
+                    b->adr = b->base + (op->mode == AbsX ? emu->x : op->mode == AbsY ? emu->y : 0);
+                    if (op->mode != Abs && (PAGE_CROSSED(b->base, b->adr) || !reads))
+                        b->start++;
+                } else {
+                    // the index was added to the low byte only, the high byte is fixed up next cycle
+                    fetch(emu, b, (b->base & 0xFF00) | (b->adr & 0xFF), BUS_DUMMY);
+                }
+                break;
+            case IndX:
+                if (t == 2) {
+                    b->base = fetch(emu, b, emu->pc++, 0);
+                } else if (t == 3) {
+                    fetch(emu, b, b->base, BUS_DUMMY);
+                    b->base = (zpg_t)(b->base + emu->x);
+                } else if (t == 4) {
+                    b->adr = load(emu, b, b->base);
+                } else {
+                    b->adr |= load(emu, b, (zpg_t)(b->base + 1)) << 8;
+                }
+                break;
+            case IndY:
+                if (t == 2) {
+                    b->data = fetch(emu, b, emu->pc++, 0);
+                } else if (t == 3) {
+                    b->base = load(emu, b, b->data);
+                } else if (t == 4) {
+                    b->base |= load(emu, b, (zpg_t)(b->data + 1)) << 8;
+                    b->adr = b->base + emu->y;
+                    if (PAGE_CROSSED(b->base, b->adr) || !reads)
+                        b->start++;
+                } else {
+                    fetch(emu, b, (b->base & 0xFF00) | (b->adr & 0xFF), BUS_DUMMY);
+                }
+                break;
+        }
+        return 0;
+    }
+
+    // accessing the operand
+    switch (op->kind) {
+        case K_RD:
+        case K_LD:
+            b->data = op->mode == Imd ? fetch(emu, b, emu->pc++, 0) : load(emu, b, b->adr);
+            if (op->kind == K_RD)
+                op->rd(emu, b->data);
+            else
+                g_txx_generic(emu, &b->data, reg(emu, op));
+            return 1;
+        case K_ST:
+            store(emu, b, b->adr, *reg(emu, op));
+            return 1;
+        default: // K_RMW, reads, writes the value back unchanged, then writes the result
+            if (t == b->start) {
+                b->data = load(emu, b, b->adr);
+                return 0;
+            }
+            if (t == b->start + 1) {
+                store_dummy(emu, b, b->adr, b->data);
+                return 0;
+            }
+            op->rmw(emu, &b->data);
+            store(emu, b, b->adr, b->data);
+            return 1;
+    }
+}
+
+/*
+the cycles after the opcode fetch of branches
+*/
+static int branch_cycle(emustate* emu, bus_core* b, const bus_op* op) {
+    switch (b->t) {
+        case 2:
+            b->data = fetch(emu, b, emu->pc++, 0);
+            return CHECK(emu->sr, op->flag) != op->set;
+        case 3:
+            fetch(emu, b, emu->pc, BUS_DUMMY);
+            b->adr = emu->pc + (rel_t)b->data;
+            if (!PAGE_CROSSED(emu->pc, b->adr)) {
+                emu->pc = b->adr;
+                return 1;
+            }
+            emu->pc = (emu->pc & 0xFF00) | (b->adr & 0xFF);
+            return 0;
+        default:
+            fetch(emu, b, emu->pc, BUS_DUMMY);
+            emu->pc = b->adr;
+            return 1;
+    }
+}
+
+/*
+the cycles after the opcode fetch of the hand-written instructions (CUSTOM in opcodes.def)
+*/
+static int custom_cycle(emustate* emu, bus_core* b) {
+    int t = b->t;
+    switch (b->opcode) {
+        case 0x48: // PHA
+        case 0x08: // PHP
+            if (t == 2) {
+                fetch(emu, b, emu->pc, BUS_DUMMY);
+                return 0;
+            }
+            store(emu, b, 0x100 | emu->sp--, b->opcode == 0x48 ? emu->a : emu->sr);
+            return 1;
+        case 0x68: // PLA
+        case 0x28: // PLP
+            if (t == 2) {
+                fetch(emu, b, emu->pc, BUS_DUMMY);
+                return 0;
+            }
+            if (t == 3) {
+                fetch(emu, b, 0x100 | emu->sp, BUS_DUMMY);
+                return 0;
+            }
+            b->data = load(emu, b, 0x100 | ++emu->sp);
+            if (b->opcode == 0x68)
+                g_txx_generic(emu, &b->data, &emu->a);
+            else
+                emu->sr = b->data;
+            return 1;
+        case 0x20: // JSR, pushes the address after its operand like i_jsr_abs
+            switch (t) {
+                case 2:
+                    b->adr = fetch(emu, b, emu->pc++, 0);
+                    return 0;
+                case 3:
+                    fetch(emu, b, 0x100 | emu->sp, BUS_DUMMY);
+                    return 0;
+                case 4:
+                    store(emu, b, 0x100 | emu->sp--, (abs_t)(emu->pc + 1) >> 8);
+                    return 0;
+                case 5:
+                    store(emu, b, 0x100 | emu->sp--, (emu->pc + 1) & 0xFF);
+                    return 0;
+                default:
+                    b->adr |= fetch(emu, b, emu->pc, 0) << 8;
+                    emu->pc = b->adr;
+                    return 1;
+            }
+        case 0x60: // RTS
+            switch (t) {
+                case 2:
+                    fetch(emu, b, emu->pc, BUS_DUMMY);
+                    return 0;
+                case 3:
+                    fetch(emu, b, 0x100 | emu->sp, BUS_DUMMY);
+                    return 0;
+                case 4:
+                    b->adr = load(emu, b, 0x100 | ++emu->sp);
+                    return 0;
+                case 5:
+                    b->adr |= load(emu, b, 0x100 | ++emu->sp) << 8;
+                    emu->pc = b->adr;
+                    return 0;
+                default:
+                    fetch(emu, b, emu->pc, BUS_DUMMY);
+                    return 1;
+            }
+        case 0x4C: // JMP abs
+            if (t == 2) {
+                b->adr = fetch(emu, b, emu->pc++, 0);
+                return 0;
+            }
+            emu->pc = b->adr | (fetch(emu, b, emu->pc, 0) << 8);
+            return 1;
+        case 0x6C: // JMP (ind), PC is the first pointer byte like i_jmp_indr
+            switch (t) {
+                case 2:
+                    b->base = fetch(emu, b, emu->pc++, 0);
+                    return 0;
+                case 3:
+                    b->base |= fetch(emu, b, emu->pc++, 0) << 8;
+                    return 0;
+                case 4:
+                    b->data = load(emu, b, b->base);
+                    return 0;
+                default:
+                    fetch(emu, b, (b->base & 0xFF00) | ((b->base + 1) & 0xFF), 0);
+                    emu->pc = b->data;
+                    return 1;
+            }
+        case 0x00: // BRK
+        case 0x40: // RTI
+            fetch(emu, b, emu->pc, BUS_DUMMY);
+            if (t < instr_map[b->opcode]->cycles)
+                return 0;
+            if (b->opcode == 0x00)
+                emu_raise(emu, STOP_BRK);
+            return 1;
+        default: // implied, registers and flags only
+            fetch(emu, b, emu->pc, BUS_DUMMY);
+            instr_map[b->opcode]->fptr.implied(emu);
+            return 1;
+    }
+}
+
+cycles_t bus_tick(emustate* emu) {
+    bus_core* b = emu->bus;
+    if (b->op == NULL) {
+        uint8_t opcode = ADDR(emu, emu->pc);
+        if (instr_map[opcode] == NULL) {
+            emu->stop |= STOP_INVALID;
+            return 0;
+        }
+        fetch(emu, b, emu->pc++, BUS_SYNC);
+        b->op = &bus_ops[opcode];
+        b->opcode = opcode;
+        b->t = 1;
+        b->start = access_cycle[b->op->mode];
+        return 1;
+    }
+    const bus_op* op = b->op;
+    b->t++;
+    int done;
+    if (op->kind == K_BR)
+        done = branch_cycle(emu, b, op);
+    else if (op->kind == K_CUSTOM)
+        done = custom_cycle(emu, b);
+    else if (op->mode == Acc) {
+        fetch(emu, b, emu->pc, BUS_DUMMY);
+        op->rmw(emu, &emu->a);
+        done = 1;
+    } else
+        done = memory_cycle(emu, b, op);
+    if (done)
+        b->op = NULL;
+    return 1;
+}
+
+uint64_t bus_run(emustate* emu, uint64_t budget, int resumed) {
+    bus_core* b = emu->bus;
+    uint64_t total = 0;
+    emu->budget = budget;
+    int breaks = emu->n_break != 0 && (emu->stop_mask & STOP_BREAKPOINT);
+    while (1) {
+        if (b->op != NULL) {
+            // a raised stop (budget 0) lets the instruction complete, the cycle budget does not
+            if (total >= budget && emu->stop == 0)
+                break;
+        } else {
+            if (total >= emu->budget)
+                break;
+            if (breaks && BITMAP_TEST(emu->breakpoints, emu->pc) && !(resumed && total == 0)) {
+                emu->stop |= STOP_BREAKPOINT;
+                break;
+            }
+        }
+        if (bus_tick(emu) == 0)
+            break;
+        total++;
+    }
+    return total;
+}
@@ -0,0 +1,90 @@
+#ifndef BUSCORE_H
+#define BUSCORE_H
+
+#include "types.h"
+#include "emustate.h"
+
+#include <stddef.h>
+
+/*
+Cycle-stepped bus core
+
+Runs instructions one bus cycle at a time, with the accesses a 6502 makes on each cycle: the
+opcode and operand fetches, the dummy reads of indexed addressing and implied instructions, and
+the double write of read-modify-write instructions. A hook can watch every access as it happens,
+and a run can end on any cycle, also in the middle of an instruction.
+
+The core is chosen per instance (emu_set_core in lib6502emu.h). The instruction core does not
+look at it apart from one test per slice, so instances on it run at full speed.
+
+Instruction semantics are shared with the instruction core (the g_ functions in instructions.h),
+so both end every instruction in the same state. Where the instruction core differs from a real
+6502, the bus core follows it: JSR pushes the return address itself and RTS does not add 1, JMP
+(ind) takes PC from the first pointer byte only, and BRK and RTI spend their cycles on idle reads
+of PC. Dummy accesses do not count for watches, dirty pages or the write hash.
+*/
+
+// kind of a bus access, as a bit mask
+#define BUS_WRITE (1 << 0) //a write, else a read
+#define BUS_DUMMY (1 << 1) //the value is not used (reads) or not changed (writes)
+#define BUS_SYNC  (1 << 2) //an opcode fetch, the first cycle of an instruction
+
+/*
+called for every bus cycle, after the access
+int kind: BUS_* bits
+*/
+typedef void (*bus_hook_func) (emustate* emu, abs_t adr, uint8_t value, int kind, void* ctx);
+
+struct bus_op;
+
+typedef struct bus_core {
+    bus_hook_func hook;
+    void* hook_ctx;
+    // instruction in flight, NULL between instructions
+    const struct bus_op* op;
+    uint8_t opcode;
+    // cycles of the instruction run so far, the opcode fetch is cycle 1
+    uint8_t t;
+    // cycle on which the operand is accessed, later than the base if an index crosses a page
+    uint8_t start;
+    // operand address, and the unindexed base address or pointer it is formed from
+    abs_t adr;
+    abs_t base;
+    // last value read
+    uint8_t data;
+} bus_core;
+
+/*
+return: a new bus core between instructions, NULL if allocation failed
+*/
+bus_core* bus_core_create(void);
+
+void bus_core_free(bus_core* bus);
+
+/*
+call hook on every bus cycle of emu, which has to be on the bus core. NULL removes the hook
+*/
+void bus_set_hook(emustate* emu, bus_hook_func hook, void* ctx);
+
+/*
+run one bus cycle on emu->bus
+return: 1, or 0 if an instruction would start on an invalid opcode (STOP_INVALID is raised, PC is left on it)
+*/
+cycles_t bus_tick(emustate* emu);
+
+/*
+run bus cycles until budget cycles have run, which may end in the middle of an instruction, or an
+instruction raised a stop, which ends the run once the instruction is complete
+int resumed: non-zero to not stop on a breakpoint at the starting PC (see run_slice_checked in lib6502emu.c)
+return: cycles run
+*/
+uint64_t bus_run(emustate* emu, uint64_t budget, int resumed);
+
+/*
+return: non-zero if emu is between instructions, always for the instruction core
+*/
+static inline int bus_idle(const emustate* emu) {
+    return emu->bus == NULL || emu->bus->op == NULL;
+}
+
+#endif
@@ -0,0 +1,293 @@
+#include "debug_server.h"
+#include "lib6502emu.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+// longest a client waits for the emulator thread to answer, in 1ms polls
+#define WAIT_MS 1000
+#define MEM_MAX 4096
+
+typedef struct debug_regs {
+    uint16_t pc;
+    uint8_t a, x, y, sr, sp;
+    int halted;
+    uint64_t cycles;
+} debug_regs;
+
+struct debug_server {
+    emustate* emu;
+    int fd;
+    char path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+    pthread_t thread;
+    atomic_int quit;
+    // seqlocks: odd while the emulator thread is writing the snapshot, bumped again when it is done
+    atomic_uint reg_seq;
+    debug_regs regs;
+    atomic_uint mem_seq;
+    uint8_t mem[0x10000];
+    // set by a client to have memory copied at the end of the next slice
+    atomic_int mem_wanted;
+    // halt is asked for by a client, halted is set by the emulator thread while it waits
+    atomic_int halt;
+    atomic_int halted;
+};
+
+static void sleep_ms(int ms) {
+    struct timespec ts = {0, ms * 1000000L};
+    nanosleep(&ts, NULL);
+}
+
+// emulator thread
+
+static void publish_regs(debug_server* srv, const emustate* emu, int halted) {
+    unsigned s = atomic_load_explicit(&srv->reg_seq, memory_order_relaxed);
+    atomic_store_explicit(&srv->reg_seq, s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    srv->regs = (debug_regs){emu->pc, emu->a, emu->x, emu->y, emu->sr, emu->sp, halted, emu->cycles};
+    atomic_store_explicit(&srv->reg_seq, s + 2, memory_order_release);
+}
+
+static void publish_mem(debug_server* srv, const emustate* emu) {
+    if (!atomic_exchange_explicit(&srv->mem_wanted, 0, memory_order_acquire))
+        return;
+    unsigned s = atomic_load_explicit(&srv->mem_seq, memory_order_relaxed);
+    atomic_store_explicit(&srv->mem_seq, s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(srv->mem, emu->mem, sizeof(srv->mem));
+    atomic_store_explicit(&srv->mem_seq, s + 2, memory_order_release);
+}
+
+void debug_server_publish(emustate* emu, void* ctx) {
+    debug_server* srv = ctx;
+    if (!atomic_load_explicit(&srv->halt, memory_order_relaxed)) {
+        publish_regs(srv, emu, 0);
+        publish_mem(srv, emu);
+        return;
+    }
+    publish_regs(srv, emu, 1);
+    atomic_store(&srv->halted, 1);
+    while (atomic_load(&srv->halt) && !atomic_load(&srv->quit)) {
+        publish_mem(srv, emu);
+        sleep_ms(1);
+    }
+    atomic_store(&srv->halted, 0);
+    publish_regs(srv, emu, 0);
+}
+
+// server thread
+
+static debug_regs read_regs(debug_server* srv) {
+    debug_regs r;
+    unsigned s1, s2;
+    do {
+        s1 = atomic_load_explicit(&srv->reg_seq, memory_order_acquire);
+        r = srv->regs;
+        atomic_thread_fence(memory_order_acquire);
+        s2 = atomic_load_explicit(&srv->reg_seq, memory_order_relaxed);
+    } while ((s1 & 1) || s1 != s2);
+    return r;
+}
+
+/*
+copy len bytes from adr out of a memory snapshot taken after this call
+return: 0, -1 if the emulator thread did not publish one in time
+*/
+static int read_mem(debug_server* srv, abs_t adr, int len, uint8_t* out) {
+    unsigned target = (atomic_load(&srv->mem_seq) + 2) & ~1u;
+    atomic_store_explicit(&srv->mem_wanted, 1, memory_order_release);
+    for (int waited = 0; waited <= WAIT_MS; ) {
+        unsigned s1 = atomic_load_explicit(&srv->mem_seq, memory_order_acquire);
+        if (!(s1 & 1) && (int)(s1 - target) >= 0) {
+            for (int k = 0; k < len; k++)
+                out[k] = srv->mem[(abs_t)(adr + k)];
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&srv->mem_seq, memory_order_relaxed) == s1)
+                return 0;
+            continue;
+        }
+        sleep_ms(1);
+        waited++;
+    }
+    return -1;
+}
+
+static void reply(int fd, const char* fmt, ...) {
+    char line[128];
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    if (len >= sizeof(line))
+        len = sizeof(line) - 1;
+    for (int done = 0; done < len; ) {
+        ssize_t n = send(fd, line + done, len - done, MSG_NOSIGNAL);
+        if (n <= 0)
+            return;
+        done += n;
+    }
+}
+
+/*
+run one command line
+return: non-zero if the client asked to close the connection
+*/
+static int command(debug_server* srv, int fd, const char* line) {
+    char cmd[16] = "";
+    sscanf(line, "%15s", cmd);
+    if (strcmp(cmd, "regs") == 0) {
+        debug_regs r = read_regs(srv);
+        reply(fd, "pc=%04x a=%02x x=%02x y=%02x sr=%02x sp=%02x cycles=%llu %s\n", r.pc, r.a, r.x, r.y, r.sr, r.sp,
+            (unsigned long long)r.cycles, r.halted ? "halted" : "running");
+    } else if (strcmp(cmd, "mem") == 0) {
+        unsigned adr;
+        int len = 16;
+        static uint8_t buf[MEM_MAX];
+        if (sscanf(line, "mem %x %i", &adr, &len) < 1 || adr > 0xFFFF || len < 1 || len > MEM_MAX) {
+            reply(fd, "error: usage mem <adr> [<len>]\n");
+            return 0;
+        }
+        if (read_mem(srv, adr, len, buf) != 0) {
+            reply(fd, "error: emulator not running\n");
+            return 0;
+        }
+        for (int k = 0; k < len; k += 16) {
+            char hex[16 * 3 + 1] = "";
+            for (int j = k; j < len && j < k + 16; j++)
+                sprintf(hex + (j - k) * 3, " %02x", buf[j]);
+            reply(fd, "%04x:%s\n", (abs_t)(adr + k), hex);
+        }
+    } else if (strcmp(cmd, "halt") == 0) {
+        atomic_store(&srv->halt, 1);
+        int waited = 0;
+        while (!atomic_load(&srv->halted) && waited++ < WAIT_MS)
+            sleep_ms(1);
+        if (!atomic_load(&srv->halted)) {
+            atomic_store(&srv->halt, 0);
+            reply(fd, "error: emulator not running\n");
+            return 0;
+        }
+    } else if (strcmp(cmd, "cont") == 0) {
+        atomic_store(&srv->halt, 0);
+    } else if (strcmp(cmd, "stop") == 0) {
+        emu_request_stop(srv->emu);
+        atomic_store(&srv->halt, 0);
+    } else if (strcmp(cmd, "quit") == 0) {
+        reply(fd, "ok\n");
+        return 1;
+    } else {
+        reply(fd, "error: unknown command, try regs, mem, halt, cont, stop or quit\n");
+        return 0;
+    }
+    reply(fd, "ok\n");
+    return 0;
+}
+
+static void serve_client(debug_server* srv, int fd) {
+    char buf[256];
+    int len = 0;
+    while (!atomic_load(&srv->quit)) {
+        struct pollfd p = {fd, POLLIN, 0};
+        if (poll(&p, 1, 100) <= 0)
+            continue;
+        ssize_t n = recv(fd, buf + len, sizeof(buf) - 1 - len, 0);
+        if (n <= 0)
+            return;
+        len += n;
+        char* start = buf;
+        char* nl;
+        while ((nl = memchr(start, '\n', buf + len - start)) != NULL) {
+            *nl = 0;
+            if (nl > start && nl[-1] == '\r')
+                nl[-1] = 0;
+            if (command(srv, fd, start))
+                return;
+            start = nl + 1;
+        }
+        len -= start - buf;
+        memmove(buf, start, len);
+        if (len == sizeof(buf) - 1) {
+            reply(fd, "error: line too long\n");
+            len = 0;
+        }
+    }
+}
+
+static void* serve(void* arg) {
+    debug_server* srv = arg;
+    while (!atomic_load(&srv->quit)) {
+        struct pollfd p = {srv->fd, POLLIN, 0};
+        if (poll(&p, 1, 100) <= 0)
+            continue;
+        int fd = accept(srv->fd, NULL, NULL);
+        if (fd < 0)
+            continue;
+        serve_client(srv, fd);
+        close(fd);
+    }
+    return NULL;
+}
+
+debug_server* debug_server_start(const char* path, emustate* emu) {
+    debug_server* srv = calloc(1, sizeof(debug_server));
+    if (srv == NULL)
+        return NULL;
+    if (strlen(path) >= sizeof(srv->path)) {
+        free(srv);
+        errno = ENAMETOOLONG;
+        return NULL;
+    }
+    strcpy(srv->path, path);
+    srv->emu = emu;
+    atomic_init(&srv->quit, 0);
+    atomic_init(&srv->reg_seq, 0);
+    atomic_init(&srv->mem_seq, 0);
+    atomic_init(&srv->mem_wanted, 0);
+    atomic_init(&srv->halt, 0);
+    atomic_init(&srv->halted, 0);
+    publish_regs(srv, emu, 0);
+
+    struct sockaddr_un sa = {.sun_family = AF_UNIX};
+    strcpy(sa.sun_path, path);
+    srv->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (srv->fd < 0) {
+        free(srv);
+        return NULL;
+    }
+    unlink(path);
+    int err;
+    if (bind(srv->fd, (struct sockaddr*)&sa, sizeof(sa)) != 0 || listen(srv->fd, 1) != 0) {
+        err = errno;
+    } else if ((err = pthread_create(&srv->thread, NULL, serve, srv)) == 0) {
+        emu->slice_hook = debug_server_publish;
+        emu->slice_ctx = srv;
+        return srv;
+    }
+    close(srv->fd);
+    unlink(path);
+    free(srv);
+    errno = err;
+    return NULL;
+}
+
+void debug_server_stop(debug_server* srv) {
+    if (srv == NULL)
+        return;
+    srv->emu->slice_hook = NULL;
+    srv->emu->slice_ctx = NULL;
+    atomic_store(&srv->quit, 1);
+    pthread_join(srv->thread, NULL);
+    close(srv->fd);
+    unlink(srv->path);
+    free(srv);
+}
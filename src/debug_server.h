@@ -0,0 +1,48 @@
+#ifndef DEBUG_SERVER_H
+#define DEBUG_SERVER_H
+
+#include "types.h"
+#include "emustate.h"
+
+/*
+Debugger server
+
+Serves a line protocol on a Unix socket to inspect an emulator while emu_run_until is running it,
+from another thread, without pausing it.
+
+The emulator thread publishes its registers after every slice (emustate.slice_hook) under a
+seqlock, so it never takes a lock or waits for a client; a client that reads while a snapshot is
+being written simply reads it again. Memory is only copied when a client has asked for it, at the
+end of the next slice. The run only stops when a client halts it.
+
+Commands, one per line, every reply ends with a line "ok" or "error: <reason>":
+    regs                pc=4002 a=00 x=03 y=00 sr=20 sp=ff cycles=1234 running|halted
+    mem <adr> [<len>]   hex dump of len (default 16, at most 4096) bytes from adr (hex)
+    halt                pause the emulator thread between slices, replies once it has
+    cont                continue after halt
+    stop                emu_request_stop, ends a run that stops on STOP_HOST
+    quit                close the connection
+Try it with e.g. socat - UNIX-CONNECT:<path>
+*/
+
+typedef struct debug_server debug_server;
+
+/*
+listen on a Unix socket at path (replacing a stale one) and serve clients, one at a time, on a
+thread of its own. Installs the slice hook of emu, which must not be running yet
+return: the server, or NULL with errno set if the socket or thread could not be created
+*/
+debug_server* debug_server_start(const char* path, emustate* emu);
+
+/*
+remove the slice hook, stop serving and remove the socket. emu must not be running
+*/
+void debug_server_stop(debug_server* srv);
+
+/*
+publish the registers, and memory if a client asked for it, then wait while halted.
+Installed as the slice hook, call it only from the thread running emu
+*/
+void debug_server_publish(emustate* emu, void* srv);
+
+#endif
@@ -0,0 +1,167 @@
+#include "difftest.h"
+#include "addr_idx.h"
+#include "disasm.h"
+#include "lib6502emu.h"
+#include "predecode.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+cycles_t diff_step_interp(emustate* emu) {
+    return emu_step(emu);
+}
+
+cycles_t diff_step_bus(emustate* emu) {
+    if (emu->bus == NULL && emu_set_core(emu, EMU_CORE_BUS) != 0)
+        return 0;
+    return emu_step(emu);
+}
+
+cycles_t diff_step_predecode(emustate* emu) {
+    uint64_t c = predecode_run(emu, emu->cache, 1);
+    emu->cycles += c;
+    return c;
+}
+
+/*
+a private copy of start for one engine, with a cache of its own and nothing that stops a run
+*/
+static emustate* copy_state(const emustate* start) {
+    emustate* emu = emu_create();
+    if (emu == NULL)
+        return NULL;
+    decode_cache* cache = emu->cache;
+    memcpy(emu, start, sizeof(emustate));
+    emu->cache = cache;
+    emu->bus = NULL;
+    emu->hle = NULL;
+    emu->recomp = NULL;
+    emu->cycles = 0;
+    emu->stop_mask = 0;
+    emu->stop = 0;
+    emu->slice_hook = NULL;
+    emu->n_watch = 0;
+    emu->n_read_watch = 0;
+    emu->n_break = 0;
+    memset(emu->page_flags, 0, sizeof(emu->page_flags));
+    emu->write_log = NULL;
+    emu->log_len = 0;
+    emu->log_cap = 0;
+    emu->write_hooks = HOOK_HASH;
+    emu->write_hash = 0;
+    return emu;
+}
+
+static void record(diff_result* res, const emustate* emu) {
+    int k = (res->trace_start + res->trace_len) % DIFF_TRACE_LEN;
+    if (res->trace_len == DIFF_TRACE_LEN)
+        res->trace_start = (res->trace_start + 1) % DIFF_TRACE_LEN;
+    else
+        res->trace_len++;
+    diff_trace_entry* e = &res->trace[k];
+    *e = (diff_trace_entry){emu->pc, {ADDR(emu, emu->pc), ADDR(emu, emu->pc+1), ADDR(emu, emu->pc+2)},
+        emu->a, emu->x, emu->y, emu->sr, emu->sp};
+}
+
+/*
+return: non-zero and a description in res->what if the engines are not in the same state
+*/
+static int compare(diff_result* res) {
+    const emustate* a = res->a;
+    const emustate* b = res->b;
+    if (a->pc != b->pc || a->a != b->a || a->x != b->x || a->y != b->y || a->sr != b->sr || a->sp != b->sp) {
+        snprintf(res->what, sizeof(res->what), "registers differ");
+        return 1;
+    }
+    if (a->write_hash != b->write_hash) {
+        for (int adr = 0; adr < 0x10000; adr++) {
+            if (a->mem[adr] != b->mem[adr]) {
+                snprintf(res->what, sizeof(res->what), "memory differs at $%04x: $%02x vs $%02x", adr, a->mem[adr], b->mem[adr]);
+                return 1;
+            }
+        }
+        snprintf(res->what, sizeof(res->what), "same memory, but different writes");
+        return 1;
+    }
+    return 0;
+}
+
+int diff_run(const emustate* start, diff_step_func step_a, diff_step_func step_b, uint64_t max_cycles, diff_result* res) {
+    memset(res, 0, sizeof(diff_result));
+    res->a = copy_state(start);
+    res->b = copy_state(start);
+    if (res->a == NULL || res->b == NULL) {
+        diff_result_free(res);
+        return -1;
+    }
+    emustate* a = res->a;
+    emustate* b = res->b;
+
+    uint64_t ca = 0, cb = 0;
+    while (ca < max_cycles) {
+        record(res, a);
+        cycles_t c = step_a(a);
+        if (c == 0) {
+            // a is on an invalid opcode, b has to stop in the same place
+            if (cb == ca && step_b(b) == 0 && !compare(res)) {
+                res->invalid = 1;
+                return 0;
+            }
+            if (res->what[0] == 0)
+                snprintf(res->what, sizeof(res->what), "only engine a stopped on an invalid opcode");
+            res->diverged = 1;
+            return 1;
+        }
+        res->instructions++;
+        ca += c;
+        while (cb < ca) {
+            c = step_b(b);
+            if (c == 0) {
+                snprintf(res->what, sizeof(res->what), "only engine b stopped on an invalid opcode");
+                res->diverged = 1;
+                return 1;
+            }
+            cb += c;
+        }
+        // b ran a fused pair past a, a catches up before they are compared
+        if (cb != ca)
+            continue;
+        if (compare(res)) {
+            res->diverged = 1;
+            return 1;
+        }
+        res->cycles = ca;
+    }
+    return 0;
+}
+
+void diff_result_free(diff_result* res) {
+    emu_destroy(res->a);
+    emu_destroy(res->b);
+    res->a = res->b = NULL;
+}
+
+static void print_state(FILE* out, const char* name, const emustate* emu) {
+    fprintf(out, "%s: PC=$%04x A=$%02x X=$%02x Y=$%02x SR=$%02x SP=$%02x writes=%016llx\n", name, emu->pc,
+        emu->a, emu->x, emu->y, emu->sr, emu->sp, (unsigned long long)emu->write_hash);
+}
+
+void diff_print(FILE* out, const diff_result* res) {
+    if (!res->diverged) {
+        fprintf(out, "no divergence after %llu instructions, %llu cycles%s\n", (unsigned long long)res->instructions,
+            (unsigned long long)res->cycles, res->invalid ? ", both stopped on an invalid opcode" : "");
+        return;
+    }
+    fprintf(out, "diverged after %llu instructions, last agreed at cycle %llu: %s\n", (unsigned long long)res->instructions,
+        (unsigned long long)res->cycles, res->what);
+    print_state(out, "a", res->a);
+    print_state(out, "b", res->b);
+    fprintf(out, "last instructions run by a:\n");
+    for (int k = 0; k < res->trace_len; k++) {
+        const diff_trace_entry* e = &res->trace[(res->trace_start + k) % DIFF_TRACE_LEN];
+        char line[DISASM_LINE_MAX];
+        int len;
+        int n = disasm_line(e->bytes, 3, e->pc, line, &len);
+        fprintf(out, "%-30.*s A=$%02x X=$%02x Y=$%02x SR=$%02x SP=$%02x\n", n - 1, line, e->a, e->x, e->y, e->sr, e->sp);
+    }
+}
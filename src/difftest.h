@@ -0,0 +1,87 @@
+#ifndef DIFFTEST_H
+#define DIFFTEST_H
+
+#include "types.h"
+#include "emustate.h"
+
+#include <stdio.h>
+
+/*
+Differential execution
+
+Runs the same program on two engines in lockstep, each on its own copy of the emulator state, and
+stops at the first point where they disagree. The engines are given as step functions, so any two of
+the interpreter, the predecoded dispatch or an outside reference core can be compared.
+
+An engine may run more than one instruction per step (a fused pair in the predecoded dispatch), so
+the states are compared whenever both have run the same number of cycles: A, X, Y, SR, SP, PC and
+the hash of every write made so far (HOOK_HASH), which keeps the check per step O(1).
+Memory itself is only compared, to name the first differing address, once the hashes differ.
+*/
+
+#define DIFF_TRACE_LEN 16
+
+/*
+run at least one instruction on emu
+return: cycles executed, 0 if PC is on an invalid opcode
+*/
+typedef cycles_t (*diff_step_func) (emustate*);
+
+// one instruction run by engine a, with the state before it
+typedef struct diff_trace_entry {
+    abs_t pc;
+    uint8_t bytes[3];
+    uint8_t a, x, y, sr, sp;
+} diff_trace_entry;
+
+typedef struct diff_result {
+    // non-zero if the engines disagreed
+    int diverged;
+    // both engines stopped on the same invalid opcode
+    int invalid;
+    // instructions run by engine a, and cycles run by both up to the last point they agreed
+    uint64_t instructions;
+    uint64_t cycles;
+    // what differed, empty if nothing did
+    char what[128];
+    // state of each engine where they stopped
+    emustate* a;
+    emustate* b;
+    // last instructions run by engine a, oldest first from trace_start
+    int trace_len;
+    int trace_start;
+    diff_trace_entry trace[DIFF_TRACE_LEN];
+} diff_result;
+
+/*
+the interpreter, one instruction per step
+*/
+cycles_t diff_step_interp(emustate* emu);
+
+/*
+the predecoded dispatch, one slot per step, using emu->cache
+*/
+cycles_t diff_step_predecode(emustate* emu);
+
+/*
+the cycle-stepped bus core (buscore.h), one instruction per step
+*/
+cycles_t diff_step_bus(emustate* emu);
+
+/*
+run copies of start on both engines until they diverge, both stop on an invalid opcode, or max_cycles
+const emustate* start: state both copies begin in, its cache and debugger state are not used
+diff_step_func step_a: the engine the trace is recorded from, usually the reference
+diff_result* res: filled in, its copies are freed by diff_result_free
+return: 1 if the engines diverged, 0 if not, -1 if allocation failed
+*/
+int diff_run(const emustate* start, diff_step_func step_a, diff_step_func step_b, uint64_t max_cycles, diff_result* res);
+
+void diff_result_free(diff_result* res);
+
+/*
+write what differed, the states of both engines and the trace leading up to it
+*/
+void diff_print(FILE* out, const diff_result* res);
+
+#endif
@@ -0,0 +1,94 @@
+#include "disasm.h"
+#include "instr_map.h"
+
+#include <string.h>
+
+static const char hex[] = "0123456789abcdef";
+
+static inline char* put_hex8(char* p, uint8_t v) {
+    p[0] = hex[v >> 4];
+    p[1] = hex[v & 0xF];
+    return p+2;
+}
+
+static inline char* put_hex16(char* p, uint16_t v) {
+    return put_hex8(put_hex8(p, v >> 8), v);
+}
+
+static inline char* put_str(char* p, const char* s) {
+    while (*s)
+        *p++ = *s++;
+    return p;
+}
+
+int disasm_line(const uint8_t* code, size_t avail, abs_t adr, char* out, int* len) {
+    const instr_info* i = instr_map[code[0]];
+    int n = (i == NULL || i->length > avail) ? 1 : i->length;
+    char* p = put_hex16(out, adr);
+
+    // bytes column, padded to 3 bytes
+    *p++ = ' ';
+    *p++ = ' ';
+    memset(p, ' ', 9);
+    for (int k = 0; k < n; k++)
+        put_hex8(p + 3*k, code[k]);
+    p += 9;
+    *p++ = ' ';
+
+    if (n == 1 && (i == NULL || i->length != 1)) {
+        p = put_str(p, ".byte $");
+        p = put_hex8(p, code[0]);
+    } else {
+        const mode_info* m = &mode_map[i->mode];
+        memcpy(p, i->name, 3);
+        p += 3;
+        if (i->mode != Impl) {
+            *p++ = ' ';
+            p = put_str(p, m->prefix);
+            if (i->mode == Rel)
+                p = put_hex16(p, adr + 2 + (rel_t)code[1]);
+            else if (n == 2)
+                p = put_hex8(p, code[1]);
+            else if (n == 3)
+                p = put_hex16(p, code[1] | (code[2] << 8));
+            p = put_str(p, m->suffix);
+        }
+    }
+    *p++ = '\n';
+    *len = n;
+    return p - out;
+}
+
+size_t disasm_image(const uint8_t* code, size_t size, abs_t base, int eof, char* out, size_t cap, size_t* consumed) {
+    size_t pos = 0, written = 0;
+    while (pos < size && cap - written >= DISASM_LINE_MAX) {
+        const instr_info* i = instr_map[code[pos]];
+        if (!eof && i != NULL && pos + i->length > size)
+            break;
+        int len;
+        written += disasm_line(code + pos, size - pos, base + pos, out + written, &len);
+        pos += len;
+    }
+    *consumed = pos;
+    return written;
+}
+
+int disasm_trace_record_len(uint8_t opcode) {
+    const instr_info* i = instr_map[opcode];
+    return 2 + (i == NULL ? 1 : i->length);
+}
+
+size_t disasm_trace(const uint8_t* trace, size_t size, char* out, size_t cap, size_t* consumed) {
+    size_t pos = 0, written = 0;
+    while (pos + 2 < size && cap - written >= DISASM_LINE_MAX) {
+        size_t rec = disasm_trace_record_len(trace[pos+2]);
+        if (pos + rec > size)
+            break;
+        int len;
+        abs_t adr = trace[pos] | (trace[pos+1] << 8);
+        written += disasm_line(trace + pos + 2, rec - 2, adr, out + written, &len);
+        pos += rec;
+    }
+    *consumed = pos;
+    return written;
+}
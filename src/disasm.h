@@ -0,0 +1,60 @@
+#ifndef DISASM_H
+#define DISASM_H
+
+#include "types.h"
+
+#include <stddef.h>
+
+/*
+Disassembler, driven by instr_map and mode_map
+
+Lines are formatted by hand straight into the caller's buffer (no malloc, no printf), as
+
+    4000  bd 34 12  LDA $1234,X
+
+address, instruction bytes, then the instruction as the assembler (asm.h) accepts it. Branch targets
+are printed as absolute addresses, bytes that are not a valid instruction as .byte.
+*/
+
+// longest line disasm_line can write, including the '\n'
+#define DISASM_LINE_MAX 32
+
+/*
+format one instruction
+const uint8_t* code: the instruction bytes
+size_t avail: number of readable bytes at code (at least 1). If the instruction is longer, its first byte is printed as .byte
+abs_t adr: address of code[0]
+char* out: room for DISASM_LINE_MAX characters, the line is written with a trailing '\n' and no NUL
+int* len: set to the number of bytes disassembled
+return: number of characters written
+*/
+int disasm_line(const uint8_t* code, size_t avail, abs_t adr, char* out, int* len);
+
+/*
+disassemble an image, as many lines as fit into out
+abs_t base: address of code[0]
+int eof: 0 if more of the image follows code, an instruction running past the end is then left for the next call.
+    Otherwise the image ends at code+size
+size_t* consumed: set to the number of bytes disassembled, the next call continues at code+consumed (address base+consumed)
+return: number of characters written
+*/
+size_t disasm_image(const uint8_t* code, size_t size, abs_t base, int eof, char* out, size_t cap, size_t* consumed);
+
+/*
+Trace records, as written by bin/6502emu -t: the address of an executed instruction (2 bytes, little
+endian) followed by the instruction's bytes (just the opcode if it is invalid)
+*/
+
+/*
+disassemble a trace, as many records as fit into out. A record cut off at the end is left for the next call
+size_t* consumed: set to the number of bytes of whole records disassembled
+return: number of characters written
+*/
+size_t disasm_trace(const uint8_t* trace, size_t size, char* out, size_t cap, size_t* consumed);
+
+/*
+return: length of the trace record for an instruction starting with opcode
+*/
+int disasm_trace_record_len(uint8_t opcode);
+
+#endif
@@ -10,11 +10,52 @@
 #define FLAG_Z 1
 #define FLAG_C 0
 
+//flag masks, used by the opcode spec to describe which flags an instruction writes
+#define F_NONE 0
+#define F_N (1 << FLAG_N)
+#define F_V (1 << FLAG_V)
+#define F_B (1 << FLAG_B)
+#define F_D (1 << FLAG_D)
+#define F_I (1 << FLAG_I)
+#define F_Z (1 << FLAG_Z)
+#define F_C (1 << FLAG_C)
+#define F_ALL (F_N | F_V | F_B | F_D | F_I | F_Z | F_C)
+
 #define SET(n,b) (n |= 1 << b)
 #define CLEAR(n,b) (n &= ~(1 << b))
 #define TOGGLE(n,b) (n ^= (1 << b))
 #define CHECK(n,b) ((n >> b) & 1)
 
+/*
+reasons for emu_run_until (lib6502emu.h) to return, as a bit mask
+*/
+#define STOP_CYCLES     (1 << 0) //cycle budget used up
+#define STOP_BREAKPOINT (1 << 1) //PC reached a breakpoint
+#define STOP_WATCH      (1 << 2) //an instruction read or wrote a watched address
+#define STOP_BRK        (1 << 3) //BRK was executed
+#define STOP_INVALID    (1 << 4) //PC is on an invalid opcode
+#define STOP_HOST       (1 << 5) //the host called emu_request_stop
+
+/*
+extra work on writes made by instructions, as a bit mask in emustate.write_hooks
+*/
+#define HOOK_WATCH (1 << 0) //check page_flags for write watches, set while any is set
+#define HOOK_HASH  (1 << 1) //fold the address and value into write_hash
+#define HOOK_DIRTY (1 << 2) //mark the page in dirty
+#define HOOK_LOG   (1 << 3) //append writes to shared pages to write_log (smp.h)
+
+/*
+per-page flags in emustate.page_flags, set while an address on the page is watched
+*/
+#define PAGE_WATCH_R (1 << 0)
+#define PAGE_WATCH_W (1 << 1)
+
+/*
+watch kinds for emu_set_watch (lib6502emu.h), as a bit mask
+*/
+#define WATCH_WRITE (1 << 0)
+#define WATCH_READ  (1 << 1)
+
 #include "stdint.h"
 
 typedef struct emustate {
@@ -30,7 +71,69 @@ typedef struct emustate {
     uint8_t sp;
     // Program Counter
     uint16_t pc;
-    uint8_t memory[256][256];
+    // Total cycles executed by emu_step/emu_run (lib6502emu.h)
+    uint64_t cycles;
+    // Predecoded dispatch cache (predecode.h), NULL to always decode from memory
+    struct decode_cache* cache;
+    // Cycle-stepped bus core (buscore.h), NULL to run whole instructions
+    struct bus_core* bus;
+    // Recompiled blocks (recomp.h) run instead of the predecoded dispatch, NULL for none
+    const struct recomp_index* recomp;
+    // cycles left in the current run or slice, set to 0 (see emu_raise) to end it after the current instruction
+    uint64_t budget;
+    // STOP_* reasons that end a run (stop_mask) and the ones raised so far (stop)
+    int stop_mask;
+    int stop;
+    // set by emu_request_stop, possibly from another thread or a signal handler
+    _Atomic int host_stop;
+    // native functions standing in for guest subroutines (emu_set_hle in lib6502emu.h), NULL if none were registered
+    struct hle_table* hle;
+    // called by emu_run_until after every slice, on the thread running it, NULL for none
+    void (*slice_hook) (struct emustate* emu, void* ctx);
+    void* slice_ctx;
+    // number of addresses set in watch/read_watch/breakpoints, bit (adr & 7) of byte (adr >> 3)
+    int n_watch;
+    int n_read_watch;
+    int n_break;
+    // non-zero to run the instruction at a breakpoint once instead of stopping, when a run resumes there
+    int skip_break;
+    // last watched address an instruction accessed
+    uint16_t watch_hit;
+    // HOOK_* work done for every write made by an instruction, see mem_written (addr_idx.h)
+    int write_hooks;
+    // running hash of the writes, kept with HOOK_HASH (difftest.h)
+    uint64_t write_hash;
+    // pages written, kept with HOOK_DIRTY, bit (page & 7) of byte (page >> 3)
+    uint8_t dirty[32];
+    // writes to the pages set in shared, kept with HOOK_LOG as (adr << 8 | value) in write order, log_cap entries
+    uint32_t* write_log;
+    uint32_t log_len;
+    uint32_t log_cap;
+    uint8_t shared[32];
+    // PAGE_* flags, so accesses to pages without a watch skip the bitmaps
+    uint8_t page_flags[256];
+    uint8_t watch[0x2000];
+    uint8_t read_watch[0x2000];
+    uint8_t breakpoints[0x2000];
+    union {
+        // memory as 256 pages of 256 bytes
+        uint8_t memory[256][256];
+        // the same memory as one flat 64K array, used by the addressing helpers (addr_idx.h)
+        uint8_t mem[0x10000];
+    };
 } emustate;
 
+#define BITMAP_TEST(map, adr) (((map)[(uint16_t)(adr) >> 3] >> ((adr) & 7)) & 1)
+
+/*
+raise a stop reason from inside an instruction. If it is in emu->stop_mask, the run returns once the
+current instruction is complete
+*/
+static inline void emu_raise(emustate* emu, int reason) {
+    if (emu->stop_mask & reason) {
+        emu->stop |= reason;
+        emu->budget = 0;
+    }
+}
+
 #endif
\ No newline at end of file
@@ -4,6 +4,14 @@
 #include "types.h"
 #include <stdlib.h>
 
+/*
+opcode -> instruction info, NULL for opcodes that are not implemented
+*/
 extern const instr_info* instr_map[256];
 
-#endif
\ No newline at end of file
+/*
+addressing mode -> operand syntax, used by the disassembler
+*/
+extern const mode_info mode_map[MODE_COUNT];
+
+#endif
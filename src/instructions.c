@@ -1,6 +1,7 @@
 #include "addr_idx.h"
 #include "bcd.h"
 #include "instructions.h"
+#include "lib6502emu.h"
 
 #include <stdlib.h> //for NULL
 
@@ -13,6 +14,8 @@
     add 1 to cycles if branch occurs on same page
     add 2 to cycles if branch occurs to different page
 
+handlers whose kind is not CUSTOM in opcodes.def are generated at the bottom of this file,
+everything above is the instruction semantics (g_ functions) and the hand-written handlers
 */
 
 // ADC instruction
@@ -59,51 +62,6 @@ void g_adc(emustate* emu, uint8_t opr) {
         CLEAR(emu->sr, FLAG_Z);
 }
 
-cycles_t i_adc_indr_x(emustate* emu, indr_t opr) {
-    int adr = u_fetch_indr_x(emu, opr);
-    g_adc(emu, ADDR(emu, adr));
-    return 6;
-}
-
-cycles_t i_adc_zpg(emustate* emu, zpg_t opr) {
-    g_adc(emu, ZPG(emu, opr));
-    return 3;
-}
-
-cycles_t i_adc_imd(emustate* emu, imd_t opr) {
-    g_adc(emu, opr);
-    return 2;
-}
-
-cycles_t i_adc_abs(emustate* emu, abs_t opr) {
-    g_adc(emu, ADDR(emu, opr));
-    return 4;
-}
-
-cycles_t i_adc_indr_y(emustate* emu, abs_t opr) {
-    cycles_t xtra = 0;
-    abs_t adr = u_fetch_indr_y(emu, opr, &xtra);
-    g_adc(emu, ADDR(emu, adr));
-    return 5 + xtra; //*
-}
-
-cycles_t i_adc_zpg_x(emustate* emu, zpg_t opr) {
-    g_adc(emu, ZPG(emu, opr+emu->x));
-    return 4;
-}
-
-cycles_t i_adc_abs_y(emustate* emu, abs_t opr) {
-    cycles_t xtra = 0;
-    g_adc(emu, u_fetch_abs_reg(emu, emu->y, opr, &xtra));
-    return 4 + xtra; //*
-}
-
-cycles_t i_adc_abs_x(emustate* emu, abs_t opr) {
-    cycles_t xtra = 0;
-    g_adc(emu, u_fetch_abs_reg(emu, emu->x, opr, &xtra));
-    return 4 + xtra; //*
-}
-
 // AND instruction
 
 void g_and(emustate* emu, uint8_t opr) {
@@ -118,50 +76,6 @@ void g_and(emustate* emu, uint8_t opr) {
         SET(emu->sr, FLAG_N);
 }
 
-cycles_t i_and_indr_x(emustate* emu, indr_t opr) {
-    g_and(emu, u_fetch_indr_x(emu, opr));
-    return 6;
-}
-
-cycles_t i_and_zpg(emustate* emu, zpg_t opr) {
-    g_and(emu, ZPG(emu, opr));
-    return 3;
-}
-
-cycles_t i_and_imd(emustate* emu, imd_t opr) {
-    g_and(emu, opr);
-    return 2;
-}
-
-cycles_t i_and_abs(emustate* emu, abs_t opr) {
-    g_and(emu, ADDR(emu, opr));
-    return 4;
-}
-
-cycles_t i_and_indr_y(emustate* emu, indr_t opr) {
-    cycles_t xtra = 0;
-    abs_t adr = u_fetch_indr_y(emu, opr, &xtra);
-    g_and(emu, ADDR(emu, adr));
-    return 5 + xtra; //*
-}
-
-cycles_t i_and_zpg_x(emustate* emu, zpg_t opr) {
-    g_and(emu, ZPG(emu, opr+emu->x));
-    return 4;
-}
-
-cycles_t i_and_abs_y(emustate* emu, abs_t opr) {
-    cycles_t xtra = 0;
-    g_and(emu, u_fetch_abs_reg(emu, emu->y, opr, &xtra));
-    return 4 + xtra; //*
-}
-
-cycles_t i_and_abs_x(emustate* emu, abs_t opr) {
-    cycles_t xtra = 0;
-    g_and(emu, u_fetch_abs_reg(emu, emu->x, opr, &xtra));
-    return 4 + xtra; //*
-}
-
 // ASL instruction
 
 void g_asl(emustate* emu, uint8_t* opr) {
@@ -184,64 +98,6 @@ void g_asl(emustate* emu, uint8_t* opr) {
 
 }
 
-cycles_t i_asl_zpg(emustate* emu, zpg_t opr) {
-    g_asl(emu, &ZPG(emu, opr));   
-    return 5; 
-}
-
-cycles_t i_asl_a(emustate* emu) {
-    g_asl(emu, &emu->a);
-    return 2;
-}
-
-cycles_t i_asl_abs(emustate* emu, abs_t opr) {
-    g_asl(emu, &ADDR(emu, opr));
-    return 6;
-}
-
-cycles_t i_asl_zpg_x(emustate* emu, zpg_t opr) {
-    g_asl(emu, &ZPG(emu, opr+emu->x));
-    return 6;
-}
-
-cycles_t i_asl_abs_x(emustate* emu, abs_t opr) {
-    g_asl(emu, &ADDR(emu, opr+emu->x));
-    return 7;
-}
-
-// BCC instruction
-
-cycles_t i_bcc_rel(emustate* emu, rel_t opr) {
-    cycles_t c = 0;
-    if (!CHECK(emu->sr, FLAG_C)) {
-        c = BRANCH_CYCLES(emu, opr);
-        emu->pc+=opr;
-    }
-    return 2 + c; //**
-}
-
-// BCS instruction
-
-cycles_t i_bcs_rel(emustate* emu, rel_t opr) {
-    cycles_t c = 0;
-    if (CHECK(emu->sr, FLAG_C)) {
-        c = BRANCH_CYCLES(emu, opr);
-        emu->pc+=opr;
-    }
-    return 2 + c; //**
-}
-
-// BEQ instruction
-
-cycles_t i_beq_rel(emustate* emu, rel_t opr) {
-    cycles_t c = 0;
-    if (CHECK(emu->sr, FLAG_Z)) {
-        c = BRANCH_CYCLES(emu, opr);
-        emu->pc+=opr;
-    }
-    return 2 + c; //**
-}
-
 // BIT instruction
 
 void g_bit(emustate* emu, uint8_t opr) {
@@ -264,49 +120,6 @@ void g_bit(emustate* emu, uint8_t opr) {
     }
 }
 
-cycles_t i_bit_zpg(emustate* emu, zpg_t opr) {
-    g_bit(emu, ZPG(emu, opr));
-    return 3;
-}
-
-cycles_t i_bit_abs(emustate* emu, abs_t opr) {
-    g_bit(emu, ADDR(emu, opr));
-    return 4;
-}
-
-// BMI instruttion
-
-cycles_t i_bmi_rel(emustate* emu, rel_t opr) {
-    cycles_t c = 0;
-    if (CHECK(emu->sr, FLAG_N)) {
-        c = BRANCH_CYCLES(emu, opr);
-        emu->pc+=opr;
-    }
-    return 2 + c; //**
-}
-
-// BNE instruction
-
-cycles_t i_bne_rel(emustate* emu, rel_t opr) {
-    cycles_t c = 0;
-    if (!CHECK(emu->sr, FLAG_Z)) {
-        c = BRANCH_CYCLES(emu, opr);
-        emu->pc+=opr;
-    }
-    return 2 + c; //**
-}
-
-// BPL instruction
-
-cycles_t i_bpl_rel(emustate* emu, rel_t opr) {
-    cycles_t c = 0;
-    if (!CHECK(emu->sr, FLAG_N)) {
-        c = BRANCH_CYCLES(emu, opr);
-        emu->pc+=opr;
-    }
-    return 2 + c; //**
-}
-
 // BRK instruction
 
 cycles_t i_brk(emustate* emu) {
@@ -314,31 +127,10 @@ cycles_t i_brk(emustate* emu) {
     // emu->memory[1][emu->sp++] = emu->pc+2;
     //TODO finish this, do more research on what it really does
     //stores PC+2 into SP?
+    emu_raise(emu, STOP_BRK);
     return 7;
 }
 
-// BVC instruction
-
-cycles_t i_bvc_rel(emustate* emu, rel_t opr) {
-    cycles_t c = 0;
-    if (!CHECK(emu->sr, FLAG_V)) {
-        c = BRANCH_CYCLES(emu, opr);
-        emu->pc+=opr;
-    }
-    return 2 + c; //**
-}
-
-// BVS
-
-cycles_t i_bvs_rel(emustate* emu, rel_t opr) {
-    cycles_t c = 0;
-    if (CHECK(emu->sr, FLAG_V)) {        
-        c = BRANCH_CYCLES(emu, opr);
-        emu->pc+=opr;
-    }
-    return 2 + c; //**
-}
-
 // CLC instruction
 
 cycles_t i_clc(emustate* emu) {
@@ -391,93 +183,18 @@ void g_cmp(emustate* emu, uint8_t opr) {
     g_comp_generic(emu, emu->a, opr);
 }
 
-cycles_t i_cmp_zpg_x(emustate* emu, zpg_t opr) {
-    g_cmp(emu, ZPG(emu, opr+emu->x));
-    return 4;
-}
-
-cycles_t i_cmp_indr_x(emustate* emu, indr_t opr) {
-    int adr = u_fetch_indr_x(emu, opr);
-    g_cmp(emu, ADDR(emu, adr));
-    return 6;
-}
-
-cycles_t i_cmp_zpg(emustate* emu, zpg_t opr) {
-    g_cmp(emu, ZPG(emu, opr));
-    return 3;
-}
-
-cycles_t i_cmp_imd(emustate* emu, imd_t opr) {
-    g_cmp(emu, opr);
-    return 2;
-}
-
-cycles_t i_cmp_abs(emustate* emu, abs_t opr) {
-    g_cmp(emu, ADDR(emu, opr));
-    return 4;
-}
-
-cycles_t i_cmp_indr_y(emustate* emu, indr_t opr) {
-    cycles_t xtra = 0;
-    abs_t adr = u_fetch_indr_y(emu, opr, &xtra);
-    g_cmp(emu, ADDR(emu, adr));
-    return 5 + xtra; //*
-}
-
-cycles_t i_cmp_abs_y(emustate* emu, abs_t opr) {
-    cycles_t xtra = 0;
-    g_cmp(emu, u_fetch_abs_reg(emu, emu->y, opr, &xtra));
-    return 4 + xtra; //*
-}
-
-cycles_t i_cmp_abs_x(emustate* emu, abs_t opr) {
-    cycles_t xtra = 0;
-    g_cmp(emu, u_fetch_abs_reg(emu, emu->x, opr, &xtra));
-    return 4 + xtra; //*
-}
-
 // CPX instruction
 
 void g_cpx(emustate* emu, uint8_t opr) {
     g_comp_generic(emu, emu->x, opr);
 }
 
-cycles_t i_cpx_imd(emustate* emu, imd_t opr) {
-    g_cpx(emu, opr);
-    return 2;
-}
-
-cycles_t i_cpx_zpg(emustate* emu, zpg_t opr) {
-    g_cpx(emu, ZPG(emu, opr));
-    return 3;
-}
-
-cycles_t i_cpx_abs(emustate* emu, abs_t opr) {
-    g_cpx(emu, ADDR(emu, opr));
-    return 4;
-}
-
 // CPY instruction
 
 void g_cpy(emustate* emu, uint8_t opr) {
     g_comp_generic(emu, emu->y, opr);
 }
 
-cycles_t i_cpy_imd(emustate* emu, imd_t opr) {
-    g_cpy(emu, opr);
-    return 2;
-}
-
-cycles_t i_cpy_zpg(emustate* emu, zpg_t opr) {
-    g_cpy(emu, ZPG(emu, opr));
-    return 3;
-}
-
-cycles_t i_cpy_abs(emustate* emu, abs_t opr) {
-    g_cpy(emu, ADDR(emu, opr));
-    return 4;
-}
-
 // DEC instruction
 
 void g_decr(emustate* emu, uint8_t* reg) {
@@ -496,26 +213,6 @@ void g_decr(emustate* emu, uint8_t* reg) {
     }
 }
 
-cycles_t i_dec_zpg(emustate* emu, zpg_t opr) {
-    g_decr(emu, &ZPG(emu, opr));
-    return 5;
-}
-
-cycles_t i_dec_abs(emustate* emu, abs_t opr) {
-    g_decr(emu, &ADDR(emu, opr));
-    return 6;
-}
-
-cycles_t i_dec_zpg_x(emustate* emu, zpg_t opr) {
-    g_decr(emu, &ZPG(emu, opr+emu->x));
-    return 6;
-}
-
-cycles_t i_dec_abs_x(emustate* emu, abs_t opr) {
-    g_decr(emu, &ADDR(emu, opr+emu->x));
-    return 7;
-}
-
 // DEX instruction
 
 cycles_t i_dex(emustate* emu) {
@@ -548,51 +245,6 @@ void g_eor(emustate* emu, uint8_t opr) {
     }
 }
 
-cycles_t i_eor_indr_x(emustate* emu, indr_t opr) {
-    int adr = u_fetch_indr_x(emu, opr);
-    g_eor(emu, ADDR(emu, adr));
-    return 6;
-}
-
-cycles_t i_eor_zpg(emustate* emu, zpg_t opr) {
-    g_eor(emu, ZPG(emu, opr));
-    return 3;
-}
-
-cycles_t i_eor_imd(emustate* emu, imd_t opr) {
-    g_eor(emu, opr);
-    return 2;
-}
-
-cycles_t i_eor_abs(emustate* emu, abs_t opr) {
-    g_eor(emu, ADDR(emu, opr));
-    return 4;
-}
-
-cycles_t i_eor_indr_y(emustate* emu, indr_t opr) {
-    cycles_t xtra = 0;
-    abs_t adr = u_fetch_indr_y(emu, opr, &xtra);
-    g_eor(emu, ADDR(emu, adr));
-    return 5 + xtra; //*
-}
-
-cycles_t i_eor_zpg_x(emustate* emu, zpg_t opr) {
-    g_eor(emu, ZPG(emu, opr+emu->x));
-    return 4;
-}
-
-cycles_t i_eor_abs_y(emustate* emu, abs_t opr) {
-    cycles_t xtra = 0;
-    g_eor(emu, u_fetch_abs_reg(emu, emu->y, opr, &xtra));
-    return 4 + xtra; //*
-}
-
-cycles_t i_eor_abs_x(emustate* emu, abs_t opr) {
-    cycles_t xtra = 0;
-    g_eor(emu, u_fetch_abs_reg(emu, emu->x, opr, &xtra));
-    return 4 + xtra; //*  
-}
-
 // INC instruction
 
 void g_incr(emustate* emu, uint8_t* reg) {
@@ -611,26 +263,6 @@ void g_incr(emustate* emu, uint8_t* reg) {
     }
 }
 
-cycles_t i_inc_zpg(emustate* emu, zpg_t opr) {
-    g_incr(emu, &ZPG(emu, opr));
-    return 5;
-}
-
-cycles_t i_inc_abs(emustate* emu, abs_t opr) {
-    g_incr(emu, &ADDR(emu, opr));
-    return 6;
-}
-
-cycles_t i_inc_zpg_x(emustate* emu, zpg_t opr) {
-    g_incr(emu, &ZPG(emu, opr+emu->x));
-    return 6;
-}
-
-cycles_t i_inc_abs_x(emustate* emu, abs_t opr) {
-    g_incr(emu, &ADDR(emu, opr+emu->x));
-    return 7;
-}
-
 // INX instruction
 
 cycles_t i_inx(emustate* emu) {
@@ -653,122 +285,21 @@ cycles_t i_jmp_abs(emustate* emu, abs_t opr) {
 }
 
 cycles_t i_jmp_indr(emustate* emu, indr_t opr) {
-    emu->pc = ADDR(emu, opr);
+    emu->pc = mem_read(emu, opr);
     return 5;
 }
 
 // JSR instruction
 
 cycles_t i_jsr_abs(emustate* emu, abs_t opr) {
-    emu->memory[1][emu->sp--] = emu->pc/256;
-    emu->memory[1][emu->sp--] = emu->pc%256;
+    if (emu->hle != NULL && emu->hle->enabled && BITMAP_TEST(emu->hle->map, opr)) //a native function stands in for the subroutine
+        return emu_hle_call(emu, opr);
+    push_8(emu, emu->pc/256);
+    push_8(emu, emu->pc%256);
     emu->pc = opr;
     return 6;
 }
 
-// LDA instruction
-
-cycles_t i_lda_indr_x(emustate* emu, indr_t opr) {
-    abs_t adr = u_fetch_indr_x(emu, opr);
-    emu->a = ADDR(emu, adr);
-    return 6;
-}
-
-cycles_t i_lda_zpg(emustate* emu, zpg_t opr) {
-    emu->a = ZPG(emu, opr);
-    return 3;
-}
-
-cycles_t i_lda_imd(emustate* emu, imd_t opr) {
-    emu->a = opr;
-    return 2;
-}
-
-cycles_t i_lda_abs(emustate* emu, abs_t opr) {
-    emu->a = ADDR(emu, opr);
-    return 4;
-}
-
-cycles_t i_lda_indr_y(emustate* emu, indr_t opr) {
-    cycles_t xtra = 0;
-    abs_t adr = u_fetch_indr_y(emu, opr, &xtra);
-    emu->a = ADDR(emu, adr);
-    return 5 + xtra; //*
-}
-
-cycles_t i_lda_abs_y(emustate* emu, abs_t opr) {
-    cycles_t xtra = 0;
-    emu->a = u_fetch_abs_reg(emu, emu->y, opr, &xtra);
-    return 4 + xtra; //*
-}
-
-cycles_t i_lda_abs_x(emustate* emu, abs_t opr) {
-    cycles_t xtra = 0;
-    emu->a = u_fetch_abs_reg(emu, emu->x, opr, &xtra);
-    return 4 + xtra; //*
-}
-
-cycles_t i_lda_zpg_x(emustate* emu, zpg_t opr) {
-    emu->a = ZPG(emu, opr+emu->x);
-    return 4;
-}
-
-// LDX instruction
-
-cycles_t i_ldx_imd(emustate* emu, imd_t opr) {
-    emu->x = opr;
-    return 2;
-}
-
-cycles_t i_ldx_zpg(emustate* emu, zpg_t opr) {
-    emu->x = ZPG(emu, opr);
-    return 3;
-}
-
-cycles_t i_ldx_abs(emustate* emu, abs_t opr) {
-    emu->x = ADDR(emu, opr);
-    return 4;
-}
-
-cycles_t i_ldx_zpg_y(emustate* emu, zpg_t opr) {
-    emu->x = ZPG(emu, opr+emu->y);
-    return 4;
-}
-
-cycles_t i_ldx_abs_y(emustate* emu, abs_t opr) {
-    cycles_t xtra = 0;
-    emu-> x = u_fetch_abs_reg(emu, emu->y, opr, &xtra);
-    return 4 + xtra; //*
-}
-
-// LDY instruction
-
-cycles_t i_ldy_imd(emustate* emu, imd_t opr) {
-    emu->y = opr;
-    return 2;
-}
-
-cycles_t i_ldy_zpg(emustate* emu, zpg_t opr) {
-    emu->y = ZPG(emu, opr);
-    return 3;
-}
-
-cycles_t i_ldy_zpg_x(emustate* emu, zpg_t opr) {
-    emu->y = ZPG(emu, opr+emu->x);
-    return 4;
-}
-
-cycles_t i_ldy_abs(emustate* emu, abs_t opr) {
-    emu->y = ADDR(emu, opr);
-    return 4;
-}
-
-cycles_t i_ldy_abs_x(emustate* emu, abs_t opr) {
-    cycles_t xtra = 0;
-    emu->y = u_fetch_abs_reg(emu, emu->x, opr, &xtra);
-    return 4 + xtra; //*
-}
-
 // LSR instruction
 
 void g_lsr(emustate* emu, uint8_t* opr) {
@@ -788,31 +319,6 @@ void g_lsr(emustate* emu, uint8_t* opr) {
 }
 
 
-cycles_t i_lsr_zpg(emustate* emu, zpg_t opr) {
-    g_lsr(emu, &ZPG(emu, opr));
-    return 5;
-}
-
-cycles_t i_lsr_a(emustate* emu) {
-    g_lsr(emu, &emu->a);
-    return 2;
-}
-
-cycles_t i_lsr_abs(emustate* emu, abs_t opr) {
-    g_lsr(emu, &ADDR(emu, opr));
-    return 6;
-}
-
-cycles_t i_lsr_zpg_x(emustate* emu, zpg_t opr) {
-    g_lsr(emu, &ZPG(emu, opr+emu->x));
-    return 6;
-}
-
-cycles_t i_lsr_abs_x(emustate* emu, abs_t opr) {
-    g_lsr(emu, &ADDR(emu, opr+emu->x));
-    return 7;
-}
-
 // NOP instruction
 
 cycles_t i_nop(emustate* emu) {
@@ -834,76 +340,32 @@ void g_ora(emustate* emu, uint8_t opr) {
         SET(emu->sr, FLAG_N);
 }
 
-cycles_t i_ora_indr_x(emustate* emu, indr_t opr) {
-    abs_t adr = u_fetch_indr_x(emu, opr);
-    g_ora(emu, ADDR(emu, adr));
-    return 6;
-}
-
-cycles_t i_ora_zpg(emustate* emu, zpg_t opr) {
-    g_ora(emu, ZPG(emu, opr));
-    return 3;
-}
-
-cycles_t i_ora_imd(emustate* emu, imd_t opr) {
-    g_ora(emu, opr);
-    return 2;
-}
-
-cycles_t i_ora_abs(emustate* emu, abs_t opr) {
-    g_ora(emu, ADDR(emu, opr));
-    return 4;
-}
-
-cycles_t i_ora_indr_y(emustate* emu, indr_t opr) {
-    cycles_t xtra = 0;
-    abs_t adr = u_fetch_indr_y(emu, opr, &xtra);
-    g_ora(emu, ADDR(emu, adr));
-    return 5 + xtra; //*
-}
-
-cycles_t i_ora_zpg_x(emustate* emu, zpg_t opr) {
-    g_ora(emu, ZPG(emu, opr+emu->x));
-    return 4;
-}
-
-cycles_t i_ora_abs_y(emustate* emu, abs_t opr) {
-    cycles_t xtra = 0;
-    g_ora(emu, u_fetch_abs_reg(emu, emu->y, opr, &xtra));
-    return 4 + xtra; //*
-}
-
-cycles_t i_ora_abs_x(emustate* emu, abs_t opr) {
-    cycles_t xtra = 0;
-    g_ora(emu, u_fetch_abs_reg(emu, emu->x, opr, &xtra));
-    return 4 + xtra; //*
-}
-
 // PHA instruction
 
 cycles_t i_pha(emustate* emu) {
-    emu->memory[1][emu->sp--] = emu->a;
+    push_8(emu, emu->a);
     return 3;
 }
 
 // PHP insturction
 
 cycles_t i_php(emustate* emu) {
-    emu->memory[1][emu->sp--] = emu->sr;
+    push_8(emu, emu->sr);
     return 3;
 }
 
 // PLA instruction
 
 cycles_t i_pla(emustate* emu) {
-    emu->a = emu->memory[1][++emu->sp];
+    uint8_t value = pull_8(emu);
+    g_txx_generic(emu, &value, &emu->a);
     return 4;
 }
 
 // PLP instruction
 
 cycles_t i_plp(emustate* emu) {
-    emu->sr = emu->memory[1][++emu->sp];
+    emu->sr = pull_8(emu);
     return 4;
 }
 
@@ -918,7 +380,7 @@ void g_rol(emustate* emu, uint8_t* opr) {
     else
         CLEAR(emu->sr, FLAG_C);
 
-    if (CHECK(emu->sr, 7)) //initial 6th bit
+    if (CHECK(*opr, 7)) //initial 6th bit
         SET(emu->sr, FLAG_N);
     else
         CLEAR(emu->sr, FLAG_N);
@@ -930,31 +392,6 @@ void g_rol(emustate* emu, uint8_t* opr) {
     
 }
 
-cycles_t i_rol_zpg(emustate* emu, zpg_t opr) {
-    g_rol(emu, &ZPG(emu, opr));
-    return 5;
-}
-
-cycles_t i_rol_a(emustate* emu) {
-    g_rol(emu, &emu->a);
-    return 2;
-}
-
-cycles_t i_rol_abs(emustate* emu, abs_t opr) {
-    g_rol(emu, &ADDR(emu, opr));
-    return 6;
-}
-
-cycles_t i_rol_zpg_x(emustate* emu, zpg_t opr) {
-    g_rol(emu, &ZPG(emu, opr+emu->x));
-    return 6;
-}
-
-cycles_t i_rol_abs_x(emustate* emu, abs_t opr) {
-    g_rol(emu, &ADDR(emu, opr+emu->x));
-    return 7;
-}
-
 // ROR instruction
 
 void g_ror(emustate* emu, uint8_t* opr) {
@@ -978,31 +415,6 @@ void g_ror(emustate* emu, uint8_t* opr) {
         CLEAR(emu->sr, FLAG_Z);
 }
 
-cycles_t i_ror_zpg(emustate* emu, zpg_t opr) {
-    g_ror(emu, &ZPG(emu, opr));
-    return 5;
-}
-
-cycles_t i_ror_a(emustate* emu) {
-    g_ror(emu, &emu->a);
-    return 2;
-}
-
-cycles_t i_ror_abs(emustate* emu, abs_t opr) {
-    g_ror(emu, &ADDR(emu, opr));
-    return 6;
-}
-
-cycles_t i_ror_zpg_x(emustate* emu, zpg_t opr) {
-    g_ror(emu, &ZPG(emu, opr+emu->x));
-    return 6;
-}
-
-cycles_t i_ror_abs_x(emustate* emu, abs_t opr) {
-    g_ror(emu, &ADDR(emu, emu->x+opr));
-    return 7;
-}
-
 // RTI instruction
 
 cycles_t i_rti(emustate* emu) {
@@ -1013,8 +425,8 @@ cycles_t i_rti(emustate* emu) {
 // RTS instruction
 
 cycles_t i_rts(emustate* emu) {
-    uint8_t low = emu->memory[1][++emu->sp];
-    uint8_t high = emu->memory[1][++emu->sp];
+    uint8_t low = pull_8(emu);
+    uint8_t high = pull_8(emu);
     emu->pc = low | (high << 8);
     return 6;
 }
@@ -1053,51 +465,6 @@ void g_sbc(emustate* emu, uint8_t opr) {
         CLEAR(emu->sr, FLAG_Z);
 }
 
-cycles_t i_sbc_indr_x(emustate* emu, indr_t opr) {
-    abs_t adr = u_fetch_indr_x(emu, opr);
-    g_sbc(emu, ADDR(emu, adr));
-    return 6;
-}
-
-cycles_t i_sbc_zpg(emustate* emu, zpg_t opr) {
-    g_sbc(emu, ZPG(emu, opr));
-    return 3;
-}
-
-cycles_t i_sbc_imd(emustate* emu, imd_t opr) {
-    g_sbc(emu, opr);
-    return 2;
-}
-
-cycles_t i_sbc_abs(emustate* emu, abs_t opr) {
-    g_sbc(emu, ADDR(emu, opr));
-    return 4;
-}
-
-cycles_t i_sbc_indr_y(emustate* emu, indr_t opr) {
-    cycles_t xtra = 0;
-    abs_t adr = u_fetch_indr_y(emu, opr, &xtra);
-    g_sbc(emu, ADDR(emu, adr));
-    return 5 + xtra; //*
-}
-
-cycles_t i_sbc_zpg_x(emustate* emu, zpg_t opr) {
-    g_sbc(emu, ZPG(emu, opr+emu->x));
-    return 4;
-}
-
-cycles_t i_sbc_abs_y(emustate* emu, abs_t opr) {
-    cycles_t xtra = 0;
-    g_sbc(emu, u_fetch_abs_reg(emu, emu->y, opr, &xtra));
-    return 4 + xtra; //*
-} 
-
-cycles_t i_sbc_abs_x(emustate* emu, abs_t opr) {
-    cycles_t xtra = 0;
-    g_sbc(emu, u_fetch_abs_reg(emu, emu->x, opr, &xtra));
-    return 4 + xtra; //*
-}
-
 // SEC instruction
 
 cycles_t i_sec(emustate* emu) {
@@ -1119,79 +486,6 @@ cycles_t i_sei(emustate* emu) {
     return 2;
 }
 
-// STA instruction
-
-cycles_t i_sta_indr_x(emustate* emu, indr_t opr) {
-    int adr = u_fetch_indr_x(emu, opr);
-    ADDR(emu, adr) = emu->a;
-    return 6;
-}
-
-cycles_t i_sta_zpg(emustate* emu, zpg_t opr) {
-    ZPG(emu, opr) = emu->a;
-    return 3;
-}
-
-cycles_t i_sta_abs(emustate* emu, abs_t opr) {
-    ADDR(emu,opr) = emu->a;
-    return 4;
-}
-
-cycles_t i_sta_indr_y(emustate* emu, indr_t opr) {
-    abs_t adr = u_fetch_indr_y(emu, opr, NULL);
-    ADDR(emu, adr) = emu->a;
-    return 6;
-}
-
-cycles_t i_sta_zpg_x(emustate* emu, zpg_t opr) {
-    ZPG(emu, opr+emu->x) = emu->a;
-    return 4;
-}
-
-cycles_t i_sta_abs_y(emustate* emu, abs_t opr) {
-    ADDR(emu, opr+emu->y) = emu->a;
-    return 5;
-}
-
-cycles_t i_sta_abs_x(emustate* emu, abs_t opr) {
-    ADDR(emu, opr+emu->x) = emu->a;
-    return 5;
-}
-
-// STX instruction
-
-cycles_t i_stx_zpg(emustate* emu, zpg_t opr) {
-    ZPG(emu, opr) = emu->x;
-    return 3;
-}
-
-cycles_t i_stx_abs(emustate* emu, abs_t opr) {
-    ADDR(emu, opr) = emu->x;
-    return 4;
-}
-
-cycles_t i_stx_zpg_y(emustate* emu, zpg_t opr) {
-    ZPG(emu, opr+emu->y) = emu->x;
-    return 4;
-}
-
-// STY instruction
-
-cycles_t i_sty_zpg(emustate* emu, zpg_t opr) {
-    ZPG(emu, opr) = emu->y;
-    return 3;
-}
-
-cycles_t i_sty_abs(emustate* emu, abs_t opr) {
-    ADDR(emu, opr) = emu->y;
-    return 4;
-}
-
-cycles_t i_sty_zpg_x(emustate* emu, zpg_t opr) {
-    ZPG(emu, opr+emu->x) = emu->y;
-    return 4;
-}
-
 // TAX instruction
 
 void g_txx_generic(emustate* emu, const uint8_t* source, uint8_t* dest) {
@@ -1249,4 +543,104 @@ cycles_t i_txs(emustate* emu) {
 cycles_t i_tya(emustate* emu) {
     g_txx_generic(emu, &emu->y, &emu->a);
     return 2;
-}
\ No newline at end of file
+}
+
+// generated handlers
+
+/*
+operand value for each addressing mode, may set xtra if a page boundary is crossed
+*/
+#define VAL_Imd  (opr)
+#define VAL_Zpg  mem_read(emu, (zpg_t)(opr))
+#define VAL_ZpgX mem_read(emu, (zpg_t)(opr+emu->x))
+#define VAL_ZpgY mem_read(emu, (zpg_t)(opr+emu->y))
+#define VAL_Abs  mem_read(emu, opr)
+#define VAL_AbsX u_fetch_abs_reg(emu, emu->x, opr, &xtra)
+#define VAL_AbsY u_fetch_abs_reg(emu, emu->y, opr, &xtra)
+#define VAL_IndX mem_read(emu, u_fetch_indr_x(emu, opr))
+#define VAL_IndY mem_read(emu, u_fetch_indr_y(emu, opr, &xtra))
+
+/*
+operand address for each addressing mode, used by stores and read-modify-write instructions
+*/
+#define ADR_Zpg  (zpg_t)(opr)
+#define ADR_ZpgX (zpg_t)(opr+emu->x)
+#define ADR_ZpgY (zpg_t)(opr+emu->y)
+#define ADR_Abs  (abs_t)(opr)
+#define ADR_AbsX (abs_t)(opr+emu->x)
+#define ADR_AbsY (abs_t)(opr+emu->y)
+#define ADR_IndX u_fetch_indr_x(emu, opr)
+#define ADR_IndY u_fetch_indr_y(emu, opr, &xtra)
+
+/*
+apply a read-modify-write g_ function to the operand, memory accesses go through mem_reading and mem_written
+*/
+#define MODIFY_Acc(fn) fn(emu, &emu->a)
+#define MODIFY_MEM(fn, mode) { \
+        abs_t adr = ADR_##mode; \
+        mem_reading(emu, adr); \
+        fn(emu, &ADDR(emu, adr)); \
+        mem_written(emu, adr); \
+    }
+#define MODIFY_Zpg(fn)  MODIFY_MEM(fn, Zpg)
+#define MODIFY_ZpgX(fn) MODIFY_MEM(fn, ZpgX)
+#define MODIFY_Abs(fn)  MODIFY_MEM(fn, Abs)
+#define MODIFY_AbsX(fn) MODIFY_MEM(fn, AbsX)
+
+/*
+branch conditions
+*/
+#define COND_cc (!CHECK(emu->sr, FLAG_C))
+#define COND_cs (CHECK(emu->sr, FLAG_C))
+#define COND_ne (!CHECK(emu->sr, FLAG_Z))
+#define COND_eq (CHECK(emu->sr, FLAG_Z))
+#define COND_pl (!CHECK(emu->sr, FLAG_N))
+#define COND_mi (CHECK(emu->sr, FLAG_N))
+#define COND_vc (!CHECK(emu->sr, FLAG_V))
+#define COND_vs (CHECK(emu->sr, FLAG_V))
+
+#define PAGE_CYCLES(page, xtra) ((page) == PX_PAGE ? (xtra) : 0)
+
+#define DEF_RD(h, mode, cyc, page, fn) \
+    SIG_##mode(h) { \
+        cycles_t xtra = 0; \
+        fn(emu, VAL_##mode); \
+        return cyc + PAGE_CYCLES(page, xtra); \
+    }
+
+#define DEF_LD(h, mode, cyc, page, reg) \
+    SIG_##mode(h) { \
+        cycles_t xtra = 0; \
+        uint8_t value = VAL_##mode; \
+        g_txx_generic(emu, &value, &emu->reg); \
+        return cyc + PAGE_CYCLES(page, xtra); \
+    }
+
+#define DEF_ST(h, mode, cyc, page, reg) \
+    SIG_##mode(h) { \
+        cycles_t xtra = 0; \
+        mem_write(emu, ADR_##mode, emu->reg); \
+        return cyc + PAGE_CYCLES(page, xtra); \
+    }
+
+#define DEF_RMW(h, mode, cyc, page, fn) \
+    SIG_##mode(h) { \
+        MODIFY_##mode(fn); \
+        return cyc; \
+    }
+
+#define DEF_BR(h, mode, cyc, page, cond) \
+    SIG_##mode(h) { \
+        cycles_t c = 0; \
+        if (COND_##cond) { \
+            c = BRANCH_CYCLES(emu, opr); \
+            emu->pc+=opr; \
+        } \
+        return cyc + c; \
+    }
+
+#define DEF_CUSTOM(h, mode, cyc, page, arg)
+
+#define OP(opc, mn, h, mode, len, cyc, page, kind, arg, flags) DEF_##kind(h, mode, cyc, page, arg)
+#include "opcodes.def"
+#undef OP
@@ -0,0 +1,163 @@
+#include "job.h"
+#include "lib6502emu.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static uint16_t get_16(const uint8_t* p) {
+    return p[0] | p[1] << 8;
+}
+
+static uint64_t get_n(const uint8_t* p, int n) {
+    uint64_t v = 0;
+    for (int k = n - 1; k >= 0; k--)
+        v = v << 8 | p[k];
+    return v;
+}
+
+static void put_n(uint8_t* p, uint64_t v, int n) {
+    for (int k = 0; k < n; k++, v >>= 8)
+        p[k] = v & 0xFF;
+}
+
+int job_parse(const uint8_t* rec, size_t len, job* out) {
+    if (len < JOB_HEADER || len > JOB_MAX_RECORD)
+        return -1;
+    out->load = get_16(rec);
+    out->entry = get_16(rec + 2);
+    out->max_cycles = get_n(rec + 4, 8);
+    out->n_ranges = rec[12];
+    size_t ranges_end = JOB_HEADER + out->n_ranges * 4;
+    if (out->n_ranges > JOB_MAX_RANGES || len < ranges_end || len - ranges_end > 0x10000)
+        return -1;
+    size_t total = 0;
+    for (int k = 0; k < out->n_ranges; k++) {
+        out->range_adr[k] = get_16(rec + JOB_HEADER + k * 4);
+        out->range_len[k] = get_16(rec + JOB_HEADER + k * 4 + 2);
+        total += out->range_len[k];
+    }
+    if (total > JOB_MAX_OUTPUT)
+        return -1;
+    out->image = rec + ranges_end;
+    out->image_len = len - ranges_end;
+    return 0;
+}
+
+/*
+the result record of job j that ended on emu with the stop reasons in stop, or of a rejected job if j is NULL
+*/
+static size_t result(const emustate* emu, int stop, const job* j, uint8_t* out) {
+    uint8_t* p = out + 4;
+    if (j == NULL) {
+        memset(p, 0, JOB_RESULT_HEADER);
+        put_n(out, JOB_RESULT_HEADER, 4);
+        return JOB_RESULT_HEADER + 4;
+    }
+    p[0] = stop;
+    put_n(p + 1, emu->pc, 2);
+    p[3] = emu->a;
+    p[4] = emu->x;
+    p[5] = emu->y;
+    p[6] = emu->sr;
+    p[7] = emu->sp;
+    put_n(p + 8, emu->cycles, 8);
+    size_t len = JOB_RESULT_HEADER;
+    for (int k = 0; k < j->n_ranges; k++) {
+        for (int i = 0; i < j->range_len[k]; i++)
+            p[len++] = emu->mem[(abs_t)(j->range_adr[k] + i)];
+    }
+    put_n(out, len, 4);
+    return len + 4;
+}
+
+size_t job_run(emustate* emu, const job* j, uint8_t* out) {
+    emu_reset(emu);
+    emu->cycles = 0;
+    emu_load(emu, j->load, j->image, j->image_len);
+    emu->pc = j->entry;
+    int stop = emu_run_until(emu, j->max_cycles, STOP_HOST);
+    return result(emu, stop, j, out);
+}
+
+/*
+read n bytes, waiting in polls of 100ms while quit is not set
+return: n, 0 if the stream ended (or quit was set) before the first byte, -1 on an error or if it ended later
+*/
+static ssize_t read_full(int fd, uint8_t* buf, size_t n, const atomic_int* quit) {
+    size_t done = 0;
+    while (done < n) {
+        if (quit != NULL) {
+            if (atomic_load(quit))
+                return done == 0 ? 0 : -1;
+            struct pollfd p = {fd, POLLIN, 0};
+            if (poll(&p, 1, 100) == 0)
+                continue;
+        }
+        ssize_t r = read(fd, buf + done, n - done);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0)
+            return r == 0 && done == 0 ? 0 : -1;
+        done += r;
+    }
+    return n;
+}
+
+static int write_full(int fd, const uint8_t* buf, size_t n) {
+    while (n > 0) {
+        // sockets without SIGPIPE, so a client going away is an error instead of the end of the process
+        ssize_t w = send(fd, buf, n, MSG_NOSIGNAL);
+        if (w < 0 && errno == ENOTSOCK)
+            w = write(fd, buf, n);
+        if (w < 0 && errno == EINTR)
+            continue;
+        if (w <= 0)
+            return -1;
+        buf += w;
+        n -= w;
+    }
+    return 0;
+}
+
+int job_serve(emustate* emu, int in, int out, const atomic_int* quit) {
+    uint8_t* rec = malloc(JOB_MAX_RECORD);
+    uint8_t* res = malloc(4 + JOB_RESULT_HEADER + JOB_MAX_OUTPUT);
+    int ret = -1;
+    if (rec == NULL || res == NULL)
+        goto done;
+    while (1) {
+        uint8_t head[4];
+        ssize_t r = read_full(in, head, 4, quit);
+        if (r <= 0) {
+            ret = r;
+            break;
+        }
+        size_t len = get_n(head, 4);
+        job j;
+        size_t res_len;
+        if (len > JOB_MAX_RECORD) {
+            // skip it to stay in step with the stream
+            for (size_t left = len; left > 0; ) {
+                size_t n = left < JOB_MAX_RECORD ? left : JOB_MAX_RECORD;
+                if (read_full(in, rec, n, quit) != n)
+                    goto done;
+                left -= n;
+            }
+            res_len = result(NULL, 0, NULL, res);
+        } else {
+            if (len > 0 && read_full(in, rec, len, quit) != len)
+                break;
+            res_len = job_parse(rec, len, &j) == 0 ? job_run(emu, &j, res) : result(NULL, 0, NULL, res);
+        }
+        if (write_full(out, res, res_len) != 0)
+            break;
+    }
+done:
+    free(rec);
+    free(res);
+    return ret;
+}
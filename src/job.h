@@ -0,0 +1,80 @@
+#ifndef JOB_H
+#define JOB_H
+
+#include "types.h"
+#include "emustate.h"
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+/*
+Batch jobs
+
+A job is a program image to run from a clean machine, and a result is the state it ended in. Both
+are binary records framed by their length, so any number of them can follow each other on one
+stream: a socket of the job server (job_server.h), or stdin and stdout of bin/6502emu.
+
+All numbers are little endian.
+
+Job record:
+    u32 length of the rest of the record
+    u16 load address of the image
+    u16 entry PC
+    u64 cycle budget, the job stops at the first instruction boundary at or past it
+    u8  number of memory ranges to return, at most JOB_MAX_RANGES
+        per range: u16 address, u16 length (wrapping around at the end of memory)
+    the image, up to 64K bytes, the rest of the record
+
+Result record, one per job and in the same order:
+    u32 length of the rest of the record
+    u8  STOP_* reasons the job ended with (STOP_CYCLES or STOP_INVALID, STOP_HOST if the host
+        stopped it with emu_request_stop), 0 if it was rejected
+    u16 PC, then u8 A, X, Y, SR, SP
+    u64 cycles run
+    the bytes of every range, in the order asked for, none for a rejected job
+
+A job is rejected if it asks for more than JOB_MAX_RANGES ranges or JOB_MAX_OUTPUT bytes in them, or
+if its record is too short or long. The stream goes on with the next record either way.
+*/
+
+#define JOB_MAX_RANGES 16
+#define JOB_MAX_OUTPUT 0x10000
+#define JOB_HEADER 13
+#define JOB_MAX_RECORD (JOB_HEADER + JOB_MAX_RANGES * 4 + 0x10000)
+#define JOB_RESULT_HEADER 16
+
+typedef struct job {
+    abs_t load;
+    abs_t entry;
+    uint64_t max_cycles;
+    int n_ranges;
+    abs_t range_adr[JOB_MAX_RANGES];
+    uint16_t range_len[JOB_MAX_RANGES];
+    const uint8_t* image;
+    size_t image_len;
+} job;
+
+/*
+const uint8_t* rec: a job record after its length field, len bytes
+job* out: filled in, out->image points into rec
+return: 0, or -1 if the job is rejected
+*/
+int job_parse(const uint8_t* rec, size_t len, job* out);
+
+/*
+reset emu and run the job on it. emu should track dirty pages (emu_track_dirty), so the reset only
+clears what the previous job touched
+uint8_t* out: the result record, including its length field, at least JOB_RESULT_HEADER + 4 + JOB_MAX_OUTPUT bytes
+return: length of the result record
+*/
+size_t job_run(emustate* emu, const job* j, uint8_t* out);
+
+/*
+read job records from fd in until it ends, run each on emu and write its result to fd out
+const atomic_int* quit: checked while waiting for input, returns once it is set. May be NULL
+return: 0 once in ended between records (or quit was set), -1 on a read or write error or a
+stream ending in the middle of a record
+*/
+int job_serve(emustate* emu, int in, int out, const atomic_int* quit);
+
+#endif
@@ -0,0 +1,122 @@
+#include "job_server.h"
+#include "job.h"
+#include "lib6502emu.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+typedef struct worker {
+    struct job_server* srv;
+    emustate* emu;
+    pthread_t thread;
+    int started;
+} worker;
+
+struct job_server {
+    int fd;
+    int bound;
+    char path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+    atomic_int quit;
+    int n_workers;
+    worker workers[JOB_SERVER_MAX_WORKERS];
+};
+
+static void* serve(void* arg) {
+    worker* w = arg;
+    job_server* srv = w->srv;
+    while (!atomic_load(&srv->quit)) {
+        struct pollfd p = {srv->fd, POLLIN, 0};
+        if (poll(&p, 1, 100) <= 0)
+            continue;
+        // the socket is non-blocking, another worker may have taken the connection
+        int fd = accept(srv->fd, NULL, NULL);
+        if (fd < 0)
+            continue;
+        fcntl(fd, F_SETFL, 0);
+        job_serve(w->emu, fd, fd, &srv->quit);
+        close(fd);
+    }
+    return NULL;
+}
+
+job_server* job_server_start(const char* path, int n_workers) {
+    if (n_workers < 1 || n_workers > JOB_SERVER_MAX_WORKERS) {
+        errno = EINVAL;
+        return NULL;
+    }
+    job_server* srv = calloc(1, sizeof(job_server));
+    if (srv == NULL)
+        return NULL;
+    if (strlen(path) >= sizeof(srv->path)) {
+        free(srv);
+        errno = ENAMETOOLONG;
+        return NULL;
+    }
+    strcpy(srv->path, path);
+    srv->fd = -1;
+    atomic_init(&srv->quit, 0);
+    srv->n_workers = n_workers;
+
+    int err = 0;
+    // the emulators are allocated and zeroed now, so the first job of a worker runs as fast as the rest
+    for (int k = 0; k < n_workers && err == 0; k++) {
+        srv->workers[k].srv = srv;
+        srv->workers[k].emu = emu_create();
+        if (srv->workers[k].emu == NULL)
+            err = ENOMEM;
+        else
+            emu_track_dirty(srv->workers[k].emu, 1);
+    }
+    struct sockaddr_un sa = {.sun_family = AF_UNIX};
+    strcpy(sa.sun_path, path);
+    if (err == 0 && (srv->fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+        err = errno;
+    if (err == 0) {
+        unlink(path);
+        if (bind(srv->fd, (struct sockaddr*)&sa, sizeof(sa)) != 0)
+            err = errno;
+        else
+            srv->bound = 1;
+    }
+    if (err == 0 && (listen(srv->fd, 16) != 0 || fcntl(srv->fd, F_SETFL, O_NONBLOCK) != 0))
+        err = errno;
+    for (int k = 0; k < n_workers && err == 0; k++) {
+        err = pthread_create(&srv->workers[k].thread, NULL, serve, &srv->workers[k]);
+        srv->workers[k].started = err == 0;
+    }
+    if (err != 0) {
+        job_server_stop(srv);
+        errno = err;
+        return NULL;
+    }
+    return srv;
+}
+
+void job_server_stop(job_server* srv) {
+    if (srv == NULL)
+        return;
+    atomic_store(&srv->quit, 1);
+    // a job can run for as long as its budget says, end the ones running now
+    for (int k = 0; k < srv->n_workers; k++) {
+        if (srv->workers[k].emu != NULL)
+            emu_request_stop(srv->workers[k].emu);
+    }
+    for (int k = 0; k < srv->n_workers; k++) {
+        if (srv->workers[k].started)
+            pthread_join(srv->workers[k].thread, NULL);
+        emu_destroy(srv->workers[k].emu);
+    }
+    if (srv->fd >= 0)
+        close(srv->fd);
+    if (srv->bound)
+        unlink(srv->path);
+    free(srv);
+}
@@ -0,0 +1,35 @@
+#ifndef JOB_SERVER_H
+#define JOB_SERVER_H
+
+#include "types.h"
+#include "emustate.h"
+
+/*
+Job server
+
+Listens on a Unix socket for streams of job records (job.h) and writes back a result record for
+each, in order, so a client pays for connecting once instead of for starting a process per program.
+
+A pool of worker threads each own an emulator that is created, with its predecode cache, when the
+server starts and then reused for every job. It tracks dirty pages, so the reset before a job only
+clears the pages the previous job touched. Each worker serves one connection at a time, so up to
+that many clients run their jobs in parallel and any more wait to be accepted.
+*/
+
+#define JOB_SERVER_MAX_WORKERS 64
+
+typedef struct job_server job_server;
+
+/*
+listen on a Unix socket at path (replacing a stale one) with n_workers workers
+return: the server, or NULL with errno set if the socket, an emulator or a thread could not be created
+*/
+job_server* job_server_start(const char* path, int n_workers);
+
+/*
+stop accepting, stop the jobs the workers are running (their results have stop reason STOP_HOST)
+and close their connections, then remove the socket
+*/
+void job_server_stop(job_server* srv);
+
+#endif
@@ -0,0 +1,427 @@
+#include "lib6502emu.h"
+#include "addr_idx.h"
+#include "buscore.h"
+#include "instr_map.h"
+#include "predecode.h"
+#include "recomp.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+emustate* emu_create(void) {
+    emustate* emu = malloc(sizeof(emustate));
+    if (emu == NULL)
+        return NULL;
+    emu_init(emu);
+    emu->cache = decode_cache_create();
+    if (emu->cache == NULL) {
+        free(emu);
+        return NULL;
+    }
+    return emu;
+}
+
+void emu_destroy(emustate* emu) {
+    if (emu == NULL)
+        return;
+    decode_cache_free(emu->cache);
+    bus_core_free(emu->bus);
+    free(emu->hle);
+    free(emu);
+}
+
+void emu_init(emustate* emu) {
+    emu->cycles = 0;
+    emu->cache = NULL;
+    emu->bus = NULL;
+    emu->recomp = NULL;
+    emu->budget = 0;
+    emu->stop_mask = 0;
+    emu->stop = 0;
+    atomic_init(&emu->host_stop, 0);
+    emu->hle = NULL;
+    emu->slice_hook = NULL;
+    emu->slice_ctx = NULL;
+    emu->n_watch = 0;
+    emu->n_read_watch = 0;
+    emu->n_break = 0;
+    emu->skip_break = 0;
+    emu->watch_hit = 0;
+    emu->write_hooks = 0;
+    emu->write_hash = 0;
+    memset(emu->dirty, 0, sizeof(emu->dirty));
+    emu->write_log = NULL;
+    emu->log_len = 0;
+    emu->log_cap = 0;
+    memset(emu->shared, 0, sizeof(emu->shared));
+    memset(emu->page_flags, 0, sizeof(emu->page_flags));
+    memset(emu->watch, 0, sizeof(emu->watch));
+    memset(emu->read_watch, 0, sizeof(emu->read_watch));
+    memset(emu->breakpoints, 0, sizeof(emu->breakpoints));
+    emu_reset(emu);
+}
+
+void emu_reset(emustate* emu) {
+    emu->a=0;
+    emu->pc=0;
+    emu->sp=0xFF;
+    emu->sr=(1 << 5); //bit 5 should always be set
+    emu->x=0;
+    emu->y=0;
+    if (emu->bus != NULL)
+        emu->bus->op = NULL;
+    if (!(emu->write_hooks & HOOK_DIRTY)) {
+        memset(emu->mem, 0, sizeof(emu->mem));
+        return;
+    }
+    for (int page = 0; page < 256; page++)
+        if (BITMAP_TEST(emu->dirty, page))
+            memset(emu->memory[page], 0, 256);
+    memset(emu->dirty, 0, sizeof(emu->dirty));
+}
+
+/*
+execute the instruction at PC
+return: cycles taken, 0 (and STOP_INVALID raised) if the opcode is invalid
+*/
+static inline cycles_t step(emustate* emu) {
+    const instr_info* i = instr_map[ADDR(emu, emu->pc)];
+    if (i == NULL) {
+        emu->stop |= STOP_INVALID;
+        return 0;
+    }
+    emu->pc++;
+    return i->exec(emu);
+}
+
+/*
+run until budget cycles have executed, an invalid opcode is reached, or an instruction raises a stop
+return: cycles executed
+*/
+static uint64_t run_slice(emustate* emu, uint64_t budget) {
+    uint64_t total = 0;
+    if (emu->bus != NULL) {
+        total = bus_run(emu, budget, 0);
+    } else if (emu->recomp != NULL) {
+        total = recomp_run(emu, emu->recomp, budget);
+    } else if (emu->cache != NULL) {
+        total = predecode_run(emu, emu->cache, budget);
+    } else {
+        emu->budget = budget;
+        while (total < emu->budget) {
+            cycles_t c = step(emu);
+            if (c == 0)
+                break;
+            total += c;
+        }
+    }
+    emu->cycles += total;
+    return total;
+}
+
+/*
+run_slice for the plain interpreter while breakpoints are set: PC is checked against them before
+every instruction. The predecoded dispatch traps breakpoints in their slots instead (predecode.h),
+recompiled blocks cannot, so they are not used while breakpoints are set
+int resumed: non-zero to not stop on a breakpoint at the starting PC, so a run that stopped there can continue
+*/
+static uint64_t run_slice_checked(emustate* emu, uint64_t budget, int resumed) {
+    uint64_t total = 0;
+    emu->budget = budget;
+    while (total < emu->budget) {
+        if (BITMAP_TEST(emu->breakpoints, emu->pc) && !(resumed && total == 0)) {
+            emu->stop |= STOP_BREAKPOINT;
+            break;
+        }
+        cycles_t c = step(emu);
+        if (c == 0)
+            break;
+        total += c;
+    }
+    emu->cycles += total;
+    return total;
+}
+
+/*
+run the bus core to the end of the instruction in flight, or through the next one
+*/
+static cycles_t bus_step(emustate* emu) {
+    cycles_t c = 0;
+    do {
+        if (bus_tick(emu) == 0)
+            break;
+        c++;
+    } while (!bus_idle(emu));
+    return c;
+}
+
+cycles_t emu_step(emustate* emu) {
+    cycles_t c = emu->bus != NULL ? bus_step(emu) : step(emu);
+    emu->cycles += c;
+    return c;
+}
+
+int emu_set_core(emustate* emu, enum emu_core core) {
+    if (core == EMU_CORE_BUS && emu->bus == NULL) {
+        emu->bus = bus_core_create();
+        if (emu->bus == NULL)
+            return -1;
+    } else if (core == EMU_CORE_INSTR && emu->bus != NULL) {
+        if (!bus_idle(emu))
+            emu->cycles += bus_step(emu);
+        bus_core_free(emu->bus);
+        emu->bus = NULL;
+    }
+    return 0;
+}
+
+uint64_t emu_run(emustate* emu, uint64_t cycles) {
+    emu->stop_mask = 0;
+    emu->stop = 0;
+    return run_slice(emu, cycles);
+}
+
+int emu_run_until(emustate* emu, uint64_t max_cycles, int stop_mask) {
+    emu->stop_mask = stop_mask;
+    emu->stop = 0;
+    int resumed = 1;
+    emu->skip_break = emu->n_break != 0 && BITMAP_TEST(emu->breakpoints, emu->pc);
+    uint64_t left = max_cycles;
+    // instructions raise stops by ending the slice early, everything else is checked once per slice
+    while (emu->stop == 0) {
+        if ((stop_mask & STOP_HOST) && atomic_exchange(&emu->host_stop, 0)) {
+            emu->stop = STOP_HOST;
+            break;
+        }
+        if (left == 0) {
+            emu->stop = STOP_CYCLES;
+            break;
+        }
+        uint64_t slice = left < EMU_SLICE_CYCLES ? left : EMU_SLICE_CYCLES;
+        uint64_t n;
+        if (emu->bus != NULL) {
+            n = bus_run(emu, slice, resumed);
+            emu->cycles += n;
+        } else if ((emu->cache == NULL || emu->recomp != NULL) && emu->n_break != 0 && (stop_mask & STOP_BREAKPOINT))
+            n = run_slice_checked(emu, slice, resumed);
+        else
+            n = run_slice(emu, slice);
+        resumed = 0;
+        left -= n < left ? n : left;
+        if (emu->slice_hook != NULL)
+            emu->slice_hook(emu, emu->slice_ctx);
+    }
+    return emu->stop;
+}
+
+void emu_request_stop(emustate* emu) {
+    atomic_store(&emu->host_stop, 1);
+}
+
+static void bitmap_set(uint8_t* map, int* count, abs_t adr, int on) {
+    uint8_t bit = 1 << (adr & 7);
+    if (on && !(map[adr >> 3] & bit)) {
+        map[adr >> 3] |= bit;
+        (*count)++;
+    } else if (!on && (map[adr >> 3] & bit)) {
+        map[adr >> 3] &= ~bit;
+        (*count)--;
+    }
+}
+
+void emu_set_breakpoint(emustate* emu, abs_t adr, int on) {
+    bitmap_set(emu->breakpoints, &emu->n_break, adr, on);
+    if (emu->cache != NULL)
+        decode_cache_invalidate(emu->cache, adr);
+}
+
+/*
+return: non-zero if any address on page is set in map
+*/
+static int page_any(const uint8_t* map, uint8_t page) {
+    for (int k = 0; k < 32; k++)
+        if (map[page * 32 + k] != 0)
+            return 1;
+    return 0;
+}
+
+void emu_set_watch(emustate* emu, abs_t adr, int kinds) {
+    bitmap_set(emu->watch, &emu->n_watch, adr, kinds & WATCH_WRITE);
+    bitmap_set(emu->read_watch, &emu->n_read_watch, adr, kinds & WATCH_READ);
+    uint8_t page = adr >> 8;
+    emu->page_flags[page] = (page_any(emu->watch, page) ? PAGE_WATCH_W : 0)
+        | (page_any(emu->read_watch, page) ? PAGE_WATCH_R : 0);
+    if (emu->n_watch != 0)
+        emu->write_hooks |= HOOK_WATCH;
+    else
+        emu->write_hooks &= ~HOOK_WATCH;
+}
+
+int emu_set_hle(emustate* emu, abs_t adr, emu_hle_func fn, void* ctx, cycles_t cycles) {
+    if (emu->hle == NULL) {
+        if (fn == NULL)
+            return 0;
+        if ((emu->hle = calloc(1, sizeof(hle_table))) == NULL)
+            return -1;
+    }
+    hle_table* t = emu->hle;
+    int k = 0;
+    while (k < t->n && t->hooks[k].adr != adr)
+        k++;
+    if (fn == NULL) {
+        if (k < t->n) {
+            t->hooks[k] = t->hooks[--t->n];
+            t->map[adr >> 3] &= ~(1 << (adr & 7));
+        }
+        return 0;
+    }
+    if (k == EMU_HLE_MAX)
+        return -1;
+    if (k == t->n)
+        t->n++;
+    t->hooks[k] = (emu_hle){adr, fn, ctx, cycles};
+    t->map[adr >> 3] |= 1 << (adr & 7);
+    t->enabled = 1;
+    return 0;
+}
+
+void emu_enable_hle(emustate* emu, int on) {
+    if (emu->hle != NULL)
+        emu->hle->enabled = on;
+}
+
+cycles_t emu_hle_call(emustate* emu, abs_t adr) {
+    const hle_table* t = emu->hle;
+    for (int k = 0; k < t->n; k++) {
+        if (t->hooks[k].adr == adr) {
+            uint32_t c = t->hooks[k].cycles + t->hooks[k].fn(emu, t->hooks[k].ctx);
+            // 0 cycles would read as an invalid opcode to the run loops
+            return c == 0 ? 1 : c > UINT16_MAX ? UINT16_MAX : c;
+        }
+    }
+    return 0;
+}
+
+uint8_t emu_read(const emustate* emu, abs_t adr) {
+    return ADDR(emu, adr);
+}
+
+void emu_write(emustate* emu, abs_t adr, uint8_t value) {
+    ADDR(emu, adr) = value;
+    emu_mark_dirty(emu, adr, 1);
+}
+
+void emu_load(emustate* emu, abs_t adr, const uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len; i++)
+        ADDR(emu, adr+i) = data[i];
+    emu_mark_dirty(emu, adr, len);
+}
+
+// dirty pages
+
+#define MARK_PAGE(map, page) ((map)[(page) >> 3] |= 1 << ((page) & 7))
+
+void emu_track_dirty(emustate* emu, int on) {
+    if (!on) {
+        emu->write_hooks &= ~HOOK_DIRTY;
+        return;
+    }
+    static const uint8_t zero[256];
+    memset(emu->dirty, 0, sizeof(emu->dirty));
+    for (int page = 0; page < 256; page++)
+        if (memcmp(emu->memory[page], zero, 256) != 0)
+            MARK_PAGE(emu->dirty, page);
+    emu->write_hooks |= HOOK_DIRTY;
+}
+
+void emu_mark_dirty(emustate* emu, abs_t adr, size_t len) {
+    if (len == 0)
+        return;
+    size_t pages = len >= 0x10000 ? 256 : (((adr & 0xFF) + len - 1) >> 8) + 1;
+    for (size_t k = 0; k < pages && k < 256; k++)
+        MARK_PAGE(emu->dirty, (uint8_t)((adr >> 8) + k));
+}
+
+/*
+return: non-zero if page has to be looked at, every page unless dirty pages are tracked
+*/
+static inline int page_dirty(const emustate* emu, int page) {
+    return !(emu->write_hooks & HOOK_DIRTY) || BITMAP_TEST(emu->dirty, page);
+}
+
+void emu_checkpoint_save(const emustate* emu, emu_checkpoint* cp) {
+    cp->a = emu->a;
+    cp->x = emu->x;
+    cp->y = emu->y;
+    cp->sr = emu->sr;
+    cp->sp = emu->sp;
+    cp->pc = emu->pc;
+    cp->cycles = emu->cycles;
+    memset(cp->pages, 0, sizeof(cp->pages));
+    for (int page = 0; page < 256; page++) {
+        if (page_dirty(emu, page)) {
+            memcpy(cp->mem + page * 256, emu->memory[page], 256);
+            MARK_PAGE(cp->pages, page);
+        }
+    }
+}
+
+void emu_checkpoint_restore(emustate* emu, const emu_checkpoint* cp) {
+    emu->a = cp->a;
+    emu->x = cp->x;
+    emu->y = cp->y;
+    emu->sr = cp->sr;
+    emu->sp = cp->sp;
+    emu->pc = cp->pc;
+    emu->cycles = cp->cycles;
+    for (int page = 0; page < 256; page++) {
+        if (BITMAP_TEST(cp->pages, page))
+            memcpy(emu->memory[page], cp->mem + page * 256, 256);
+        else if (page_dirty(emu, page))
+            memset(emu->memory[page], 0, 256);
+    }
+    if (emu->write_hooks & HOOK_DIRTY)
+        memcpy(emu->dirty, cp->pages, sizeof(emu->dirty));
+}
+
+int emu_checkpoint_diff(const emustate* emu, const emu_checkpoint* cp, uint8_t* changed) {
+    static const uint8_t zero[256];
+    int n = 0;
+    if (changed != NULL)
+        memset(changed, 0, 32);
+    for (int page = 0; page < 256; page++) {
+        if (!page_dirty(emu, page) && !BITMAP_TEST(cp->pages, page))
+            continue;
+        const uint8_t* was = BITMAP_TEST(cp->pages, page) ? cp->mem + page * 256 : zero;
+        if (memcmp(emu->memory[page], was, 256) != 0) {
+            n++;
+            if (changed != NULL)
+                MARK_PAGE(changed, page);
+        }
+    }
+    return n;
+}
+
+uint16_t emu_get_reg(const emustate* emu, enum emu_reg reg) {
+    switch (reg) {
+        case REG_A: return emu->a;
+        case REG_X: return emu->x;
+        case REG_Y: return emu->y;
+        case REG_SR: return emu->sr;
+        case REG_SP: return emu->sp;
+        case REG_PC: return emu->pc;
+    }
+    return 0;
+}
+
+void emu_set_reg(emustate* emu, enum emu_reg reg, uint16_t value) {
+    switch (reg) {
+        case REG_A: emu->a = value; break;
+        case REG_X: emu->x = value; break;
+        case REG_Y: emu->y = value; break;
+        case REG_SR: emu->sr = value; break;
+        case REG_SP: emu->sp = value; break;
+        case REG_PC: emu->pc = value; break;
+    }
+}
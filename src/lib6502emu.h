@@ -0,0 +1,229 @@
+#ifndef LIB6502EMU_H
+#define LIB6502EMU_H
+
+#include "emustate.h"
+#include "types.h"
+
+#include <stddef.h>
+
+/*
+lib6502emu - embeddable emulator core
+
+Typical use:
+
+    emustate* emu = emu_create();
+    emu_load(emu, 0x4000, program, program_len);
+    emu_set_reg(emu, REG_PC, 0x4000);
+    while (...)
+        emu_run(emu, 1000);
+    emu_destroy(emu);
+
+All state lives in the emustate, so any number of instances can be used side by side.
+*/
+
+// longest stretch of cycles run between checks of the host stop flag
+#define EMU_SLICE_CYCLES 0x4000
+
+enum emu_reg {
+    REG_A, REG_X, REG_Y, REG_SR, REG_SP, REG_PC
+};
+
+/*
+how an instance runs, see emu_set_core
+*/
+enum emu_core {
+    EMU_CORE_INSTR, // whole instructions, through recompiled blocks or the predecode cache if there are any (the default)
+    EMU_CORE_BUS    // one bus cycle at a time (buscore.h)
+};
+
+/*
+return: a new, reset emulator with a predecoded dispatch cache, or NULL if allocation failed
+*/
+emustate* emu_create(void);
+
+/*
+free an emulator returned by emu_create
+*/
+void emu_destroy(emustate* emu);
+
+/*
+initialize caller-allocated state (e.g. on the stack): no predecode cache, breakpoints or watches, cycle count 0, then reset
+*/
+void emu_init(emustate* emu);
+
+/*
+reset registers and zero all memory (only the dirty pages while tracking them, see emu_track_dirty).
+The cycle count, predecode cache, breakpoints and watches are kept
+*/
+void emu_reset(emustate* emu);
+
+/*
+execute one instruction at PC, or on the bus core the rest of the one in flight
+return: cycles taken, or 0 if the opcode at PC is invalid (PC is left on it)
+*/
+cycles_t emu_step(emustate* emu);
+
+/*
+switch emu to a core. Switching to the instruction core first completes an instruction the bus core has in flight
+return: 0, or -1 if allocation failed
+*/
+int emu_set_core(emustate* emu, enum emu_core core);
+
+/*
+run until at least the given number of cycles have executed, or an invalid opcode is reached (PC is left on it)
+return: cycles executed, may overshoot by one instruction (or fused instruction pair, loop idiom or recompiled block).
+The bus core runs exactly the given number of cycles, and may stop in the middle of an instruction
+*/
+uint64_t emu_run(emustate* emu, uint64_t cycles);
+
+/*
+run at full speed until one of the stop reasons happens
+uint64_t max_cycles: cycle budget, STOP_CYCLES is returned once at least this many cycles have run
+int stop_mask: the other STOP_* reasons (emustate.h) to return on, STOP_INVALID always ends the run
+    STOP_BREAKPOINT: PC is on the breakpoint, the instruction has not run yet. A breakpoint at the
+                     starting PC is ignored, so calling emu_run_until again continues past it
+    STOP_WATCH:      returns after the instruction that read or wrote a watched address, the
+                     address is left in emustate.watch_hit (the last one, if it accessed several)
+    STOP_BRK:        returns after the BRK instruction
+    STOP_HOST:       checked every EMU_SLICE_CYCLES cycles, the request is cleared when it is taken
+emustate.slice_hook, if set, is called between slices, e.g. to publish state (debug_server.h)
+return: the stop reason(s), as a mask
+*/
+int emu_run_until(emustate* emu, uint64_t max_cycles, int stop_mask);
+
+/*
+ask a running emu_run_until(..., STOP_HOST) to return. Safe to call from another thread or a signal handler
+*/
+void emu_request_stop(emustate* emu);
+
+/*
+int on: non-zero to set the breakpoint at adr, 0 to clear it
+With a predecode cache the breakpoint replaces the slot at adr, so it costs nothing until it is hit;
+a cache attached after breakpoints were changed has to be flushed (decode_cache_flush)
+*/
+void emu_set_breakpoint(emustate* emu, abs_t adr, int on);
+
+/*
+watch adr for data reads and/or writes made by instructions. The check is behind a per-page flag,
+so accesses to pages without a watch pay only for testing it
+int kinds: WATCH_READ | WATCH_WRITE (emustate.h), 0 to clear the watch at adr
+*/
+void emu_set_watch(emustate* emu, abs_t adr, int kinds);
+
+/*
+High-level emulation of guest subroutines
+
+A native function can stand in for a guest subroutine: a JSR to its address runs the function
+against the emustate instead, and execution continues after the JSR as if the subroutine had
+returned. Arguments and results are passed however the guest code does, in registers or memory.
+Memory the function writes directly is not seen by watches; it should go through emu_write so
+dirty-page tracking sees it.
+
+The check is made by the JSR handler, so it applies to the interpreter, the predecoded dispatch and
+recompiled code; while no function is registered, or they are disabled, JSR runs as before. The bus
+core always runs the guest code.
+*/
+
+#define EMU_HLE_MAX 64
+
+/*
+run in place of a guest subroutine, PC is already the return address
+return: cycles the call takes on top of the fixed count it was registered with, e.g. per byte copied
+*/
+typedef cycles_t (*emu_hle_func) (emustate* emu, void* ctx);
+
+typedef struct emu_hle {
+    abs_t adr;
+    emu_hle_func fn;
+    void* ctx;
+    cycles_t cycles;
+} emu_hle;
+
+typedef struct hle_table {
+    int enabled;
+    int n;
+    // addresses that have a function, bit (adr & 7) of byte (adr >> 3)
+    uint8_t map[0x2000];
+    emu_hle hooks[EMU_HLE_MAX];
+} hle_table;
+
+/*
+register fn for the subroutine at adr, replacing one that was there, and enable the functions
+cycles_t cycles: charged for the whole call, in place of the JSR, the subroutine and its RTS
+emu_hle_func fn: NULL to remove the function at adr
+return: 0, or -1 if allocation failed or EMU_HLE_MAX functions are registered
+*/
+int emu_set_hle(emustate* emu, abs_t adr, emu_hle_func fn, void* ctx, cycles_t cycles);
+
+/*
+int on: 0 to run the guest subroutines again without removing the functions, non-zero to use them
+*/
+void emu_enable_hle(emustate* emu, int on);
+
+/*
+called by the JSR handler when its target has a function
+return: cycles charged for the call, at least 1
+*/
+cycles_t emu_hle_call(emustate* emu, abs_t adr);
+
+uint8_t emu_read(const emustate* emu, abs_t adr);
+
+void emu_write(emustate* emu, abs_t adr, uint8_t value);
+
+/*
+copy len bytes into memory starting at adr, wrapping around at the end of memory
+*/
+void emu_load(emustate* emu, abs_t adr, const uint8_t* data, size_t len);
+
+/*
+Dirty-page tracking
+
+While on, emustate.dirty holds every page that may be non-zero: pages written by instructions and
+through emu_write/emu_load since the last emu_reset. Reset, checkpoints and diffs then only touch
+those pages, which for short-running guests is a few out of 256. A host writing emustate.memory
+directly has to call emu_mark_dirty.
+*/
+
+/*
+int on: non-zero to start tracking (pages holding non-zero bytes now are marked), 0 to stop
+*/
+void emu_track_dirty(emustate* emu, int on);
+
+/*
+mark the pages holding len bytes starting at adr, wrapping around at the end of memory
+*/
+void emu_mark_dirty(emustate* emu, abs_t adr, size_t len);
+
+typedef struct emu_checkpoint {
+    uint8_t a, x, y, sr, sp;
+    uint16_t pc;
+    uint64_t cycles;
+    // pages stored in mem, the others were all zero
+    uint8_t pages[32];
+    uint8_t mem[0x10000];
+} emu_checkpoint;
+
+/*
+save registers and memory, only the dirty pages while tracking
+*/
+void emu_checkpoint_save(const emustate* emu, emu_checkpoint* cp);
+
+/*
+return to a checkpoint of this emulator, writing only pages that are dirty now or were at the checkpoint
+*/
+void emu_checkpoint_restore(emustate* emu, const emu_checkpoint* cp);
+
+/*
+uint8_t* changed: set to the pages whose memory differs from the checkpoint, 32 bytes, may be NULL
+return: number of pages that differ, only dirty pages are compared while tracking
+*/
+int emu_checkpoint_diff(const emustate* emu, const emu_checkpoint* cp, uint8_t* changed);
+
+uint16_t emu_get_reg(const emustate* emu, enum emu_reg reg);
+
+/*
+set a register, values are truncated to the register's width
+*/
+void emu_set_reg(emustate* emu, enum emu_reg reg, uint16_t value);
+
+#endif
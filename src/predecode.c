@@ -0,0 +1,619 @@
+#include "predecode.h"
+#include "addr_idx.h"
+#include "instr_map.h"
+#include "instructions.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+per-handler constants from opcodes.def, used to check fusion.def at compile time and by the fused
+handlers. WRITESOF_ is set for instructions that write memory: stores, read-modify-writes and the
+pushes of PHA and PHP (the other hand-written ones that write never start a pair)
+*/
+#define WRITES_RD     0
+#define WRITES_LD     0
+#define WRITES_ST     1
+#define WRITES_RMW    1
+#define WRITES_BR     0
+#define WRITES_CUSTOM 0
+
+enum {
+#define OP(opc, mn, h, mode, len, cyc, page, kind, arg, flags) \
+    OPC_##h = opc, MODEOF_##h = mode, FLAGSOF_##h = flags, CYCOF_##h = cyc, LENOF_##h = len, \
+    WRITESOF_##h = WRITES_##kind || opc == 0x48 || opc == 0x08,
+#include "opcodes.def"
+#undef OP
+};
+
+/*
+handler argument built from a slot operand, for each addressing mode
+*/
+#define ARG_Impl(v)
+#define ARG_Acc(v)
+#define ARG_Imd(v)  , (imd_t)(v)
+#define ARG_Zpg(v)  , (zpg_t)(v)
+#define ARG_ZpgX(v) , (zpg_t)(v)
+#define ARG_ZpgY(v) , (zpg_t)(v)
+#define ARG_Abs(v)  , (abs_t)(v)
+#define ARG_AbsX(v) , (abs_t)(v)
+#define ARG_AbsY(v) , (abs_t)(v)
+#define ARG_Ind(v)  , (indr_t)(v)
+#define ARG_IndX(v) , (indr_t)(v)
+#define ARG_IndY(v) , (indr_t)(v)
+#define ARG_Rel(v)  , (rel_t)(v)
+
+// single instructions
+
+#define OP(opc, mn, h, mode, len, cyc, page, kind, arg, flags) \
+    static cycles_t p_##h(emustate* emu, const decoded* d) { \
+        emu->pc += len; \
+        return i_##h(emu ARG_##mode(d->opr)); \
+    }
+#include "opcodes.def"
+#undef OP
+
+static const decoded_func single_map[256] = {
+#define OP(opc, mn, h, mode, len, cyc, page, kind, arg, flags) [opc] = p_##h,
+#include "opcodes.def"
+#undef OP
+};
+
+static const char* handler_names[256] = {
+#define OP(opc, mn, h, mode, len, cyc, page, kind, arg, flags) [opc] = #h,
+#include "opcodes.def"
+#undef OP
+};
+
+static const char* mode_names[MODE_COUNT] = {
+    "Impl", "Acc", "Imd", "Zpg", "ZpgX", "ZpgY", "Abs", "AbsX", "AbsY", "Ind", "IndX", "IndY", "Rel"
+};
+
+/*
+invalid opcode, leaves PC on the opcode and reports 0 cycles so predecode_run stops
+*/
+static cycles_t p_invalid(emustate* emu, const decoded* d) {
+    emu->stop |= STOP_INVALID;
+    return 0;
+}
+
+/*
+breakpoint trap, replaces the slot at every breakpoint so the dispatch loop needs no check of its own.
+Stops before the instruction, unless the run is resuming from this breakpoint (emustate.skip_break)
+*/
+static cycles_t p_break(emustate* emu, const decoded* d) {
+    if (emu->skip_break) {
+        emu->skip_break = 0;
+    } else if (emu->stop_mask & STOP_BREAKPOINT) {
+        emu->stop |= STOP_BREAKPOINT;
+        return 0;
+    }
+    decoded_func f = single_map[(uint8_t)d->key];
+    return f != NULL ? f(emu, d) : p_invalid(emu, d);
+}
+
+// slot bytes
+
+static uint8_t peek(const emustate* emu, abs_t adr) {
+    return ADDR(emu, adr);
+}
+
+/*
+operand of the instruction at adr, for an instruction of the given length
+*/
+static uint16_t peek_operand(const emustate* emu, abs_t adr, uint8_t len) {
+    if (len == 2)
+        return peek(emu, adr+1);
+    if (len == 3)
+        return peek(emu, adr+1) | (peek(emu, adr+2) << 8);
+    return 0;
+}
+
+static uint64_t peek_key(const emustate* emu, abs_t adr, uint8_t len) {
+    uint64_t key = 0;
+    for (int i = 0; i < len; i++)
+        key |= (uint64_t)peek(emu, adr+i) << (8*i);
+    return key;
+}
+
+/*
+return: non-zero if memory at adr still holds the bytes the slot was decoded from.
+only meaningful for slots that were decoded (len != 0)
+*/
+static inline int slot_valid(const emustate* emu, const decoded* d, abs_t adr) {
+    uint64_t mask = (1ULL << (8*d->len)) - 1;
+    if (adr <= 0x10000 - sizeof(uint64_t)) {
+        uint64_t mem;
+        memcpy(&mem, emu->mem + adr, sizeof(mem));
+        return (mem & mask) == d->key;
+    }
+    return peek_key(emu, adr, d->len) == d->key;
+}
+
+// superinstructions
+
+/*
+variants of implied instructions that skip computing flags, only used as the first half of a
+NOFLAGS pair in fusion.def
+*/
+static inline void nf_inx(emustate* emu) { emu->x++; }
+static inline void nf_iny(emustate* emu) { emu->y++; }
+static inline void nf_dex(emustate* emu) { emu->x--; }
+static inline void nf_dey(emustate* emu) { emu->y--; }
+
+#define FIRST_FULL(h, m, d)    i_##h(emu ARG_##m((d)->opr))
+#define FIRST_NOFLAGS(h, m, d) (nf_##h(emu), CYCOF_##h)
+
+/*
+the fused handler runs the second instruction only if the first one raised no stop, so a watch stops
+between the two as on the interpreter, and, if the first one writes memory, only if the slot's bytes
+are unchanged. Otherwise PC is left on the second instruction, which the next dispatch decodes anew.
+NOFLAGS first halves (the nf_ variants) neither touch memory nor stop, so they never end early
+*/
+#define FUSE(h1, m1, h2, m2, variant) \
+    _Static_assert((int)MODEOF_##h1 == (int)m1 && (int)MODEOF_##h2 == (int)m2, "fusion.def: wrong mode for " #h1 " or " #h2); \
+    _Static_assert(variant != NOFLAGS || (FLAGSOF_##h1 & ~FLAGSOF_##h2) == 0, "fusion.def: " #h2 " does not overwrite the flags of " #h1); \
+    static cycles_t f_##h1##__##h2(emustate* emu, const decoded* d) { \
+        abs_t adr = emu->pc; \
+        emu->pc += LENOF_##h1; \
+        cycles_t c = FIRST_##variant(h1, m1, d); \
+        if (emu->stop != 0 || (WRITESOF_##h1 && !slot_valid(emu, d, adr))) \
+            return c; \
+        emu->pc += LENOF_##h2; \
+        return c + i_##h2(emu ARG_##m2(d->opr2)); \
+    }
+enum { FULL, NOFLAGS };
+#include "fusion.def"
+#undef FUSE
+
+typedef struct fusion {
+    uint8_t first;
+    uint8_t second;
+    decoded_func exec;
+} fusion;
+
+static const fusion fusions[] = {
+#define FUSE(h1, m1, h2, m2, variant) {OPC_##h1, OPC_##h2, f_##h1##__##h2},
+#include "fusion.def"
+#undef FUSE
+};
+
+// decoding
+
+/*
+return: non-zero if the instruction may be the first half of a superinstruction
+*/
+static int fusable_first(const instr_info* i) {
+    static const char* control[] = {"BRK", "JMP", "JSR", "RTI", "RTS"};
+    if (i->mode == Rel)
+        return 0;
+    for (int k = 0; k < sizeof(control)/sizeof(control[0]); k++) {
+        if (!strcmp(i->name, control[k]))
+            return 0;
+    }
+    return 1;
+}
+
+static decoded_func find_fusion(uint8_t first, uint8_t second) {
+    for (int k = 0; k < sizeof(fusions)/sizeof(fusions[0]); k++) {
+        if (fusions[k].first == first && fusions[k].second == second)
+            return fusions[k].exec;
+    }
+    return NULL;
+}
+
+static inline int has_breakpoint(const emustate* emu, abs_t adr) {
+    return emu->n_break != 0 && BITMAP_TEST(emu->breakpoints, adr);
+}
+
+// loop idioms
+
+// longest key slot_valid can compare, longer idioms check the rest of their bytes when they run
+#define IDIOM_KEY 7
+#define IDIOM_MAX 16
+// pattern byte that matches any value, e.g. an operand
+#define ANY -1
+
+static cycles_t x_copy_indy(emustate* emu, const decoded* d);
+static cycles_t x_fill_indy(emustate* emu, const decoded* d);
+static cycles_t x_copy_absx(emustate* emu, const decoded* d);
+static cycles_t x_fill_absx(emustate* emu, const decoded* d);
+static cycles_t x_mul_shift_add(emustate* emu, const decoded* d);
+
+typedef struct idiom {
+    decoded_func exec;
+    uint8_t len;
+    int16_t bytes[IDIOM_MAX];
+} idiom;
+
+/*
+loops run in bulk by one slot at their first instruction. Every one of them branches back to that
+instruction until its counter register reaches 0
+*/
+static const idiom idioms[] = {
+    // LDA (src),Y / STA (dst),Y / INY / BNE
+    {x_copy_indy, 7, {0xB1, ANY, 0x91, ANY, 0xC8, 0xD0, 0xF9}},
+    // STA (dst),Y / INY / BNE
+    {x_fill_indy, 5, {0x91, ANY, 0xC8, 0xD0, 0xFB}},
+    // LDA src,X / STA dst,X / INX or DEX / BNE
+    {x_copy_absx, 9, {0xBD, ANY, ANY, 0x9D, ANY, ANY, 0xE8, 0xD0, 0xF7}},
+    {x_copy_absx, 9, {0xBD, ANY, ANY, 0x9D, ANY, ANY, 0xCA, 0xD0, 0xF7}},
+    // STA dst,X / INX or DEX / BNE
+    {x_fill_absx, 6, {0x9D, ANY, ANY, 0xE8, 0xD0, 0xFA}},
+    {x_fill_absx, 6, {0x9D, ANY, ANY, 0xCA, 0xD0, 0xFA}},
+    // LSR m1 / BCC +3 / CLC / ADC m2 / ROR A / ROR p / DEX / BNE: A:p = m1 * m2, X bits
+    {x_mul_shift_add, 13, {0x46, ANY, 0x90, 0x03, 0x18, 0x65, ANY, 0x6A, 0x66, ANY, 0xCA, 0xD0, 0xF3}},
+};
+
+static int idiom_match(const emustate* emu, abs_t adr, const idiom* id) {
+    if ((uint32_t)adr + id->len > 0x10000)
+        return 0;
+    for (int k = 0; k < id->len; k++) {
+        if (id->bytes[k] != ANY && id->bytes[k] != peek(emu, adr+k))
+            return 0;
+    }
+    return 1;
+}
+
+/*
+return: index in idioms of the loop at adr, -1 if there is none
+*/
+static int find_idiom(const emustate* emu, abs_t adr) {
+    for (int k = 0; k < sizeof(idioms)/sizeof(idioms[0]); k++) {
+        if (idioms[k].bytes[0] == peek(emu, adr) && idiom_match(emu, adr, &idioms[k]))
+            return k;
+    }
+    return -1;
+}
+
+/*
+return: non-zero if the idiom slot d at adr can run its loop in bulk: no watch could fire in the
+middle of it, no breakpoint is set inside it, and the bytes past its key still match
+*/
+static int idiom_ready(const emustate* emu, const decoded* d, abs_t adr) {
+    const idiom* id = &idioms[d->opr2];
+    if (emu->n_watch != 0 || emu->n_read_watch != 0)
+        return 0;
+    for (int k = 1; k < id->len; k++) {
+        if (has_breakpoint(emu, adr+k))
+            return 0;
+    }
+    return id->len <= d->len || idiom_match(emu, adr, id);
+}
+
+/*
+run only the first instruction of an idiom slot, for loops that can not run in bulk
+*/
+static cycles_t idiom_single(emustate* emu, const decoded* d) {
+    return single_map[(uint8_t)d->key](emu, d);
+}
+
+static inline int overlaps(uint32_t a, uint32_t a_len, uint32_t b, uint32_t b_len) {
+    return a < b + b_len && b < a + a_len;
+}
+
+/*
+return: number of indexes in [first, last] for which base+index is on the next page of base
+*/
+static int crossings(abs_t base, int first, int last) {
+    if ((base & 0xFF) == 0)
+        return 0;
+    int from = 0x100 - (base & 0xFF);
+    if (from < first)
+        from = first;
+    return last >= from ? last - from + 1 : 0;
+}
+
+/*
+copy n bytes from src to dst as a loop copying one byte at a time would, lowest address first if up
+is non-zero, else highest first, then run the write hooks in the same order. Neither range may wrap
+return: the last byte copied
+*/
+static uint8_t bulk_copy(emustate* emu, abs_t src, abs_t dst, int n, int up) {
+    uint8_t* m = emu->mem;
+    uint8_t last = 0;
+    // the loop reads back bytes it wrote itself if dst is ahead of src in the direction of the copy
+    if (up ? (dst > src && dst < src + n) : (dst < src && dst + n > src)) {
+        for (int k = 0; k < n; k++) {
+            int i = up ? k : n-1 - k;
+            last = m[dst + i] = m[src + i];
+        }
+    } else {
+        last = m[up ? src + n-1 : src];
+        memmove(m + dst, m + src, n);
+    }
+    if (emu->write_hooks != 0) {
+        for (int k = 0; k < n; k++)
+            mem_written(emu, dst + (up ? k : n-1 - k));
+    }
+    return last;
+}
+
+/*
+fill n bytes from dst with value, and run the write hooks as bulk_copy does
+*/
+static void bulk_fill(emustate* emu, abs_t dst, int n, uint8_t value, int up) {
+    memset(emu->mem + dst, value, n);
+    if (emu->write_hooks != 0) {
+        for (int k = 0; k < n; k++)
+            mem_written(emu, dst + (up ? k : n-1 - k));
+    }
+}
+
+static cycles_t x_copy_indy(emustate* emu, const decoded* d) {
+    abs_t adr = emu->pc;
+    zpg_t sp = d->opr, dp = peek(emu, adr+3);
+    abs_t src = ZPG(emu, sp) | ZPG(emu, (zpg_t)(sp+1)) << 8;
+    abs_t dst = ZPG(emu, dp) | ZPG(emu, (zpg_t)(dp+1)) << 8;
+    int y = emu->y, n = 0x100 - y;
+    // the stores must leave the loop and both pointers alone
+    if (!idiom_ready(emu, d, adr) || src + 0xFF > 0xFFFF || dst + 0xFF > 0xFFFF || overlaps(dst + y, n, adr, 7)
+        || overlaps(dst + y, n, sp, 1) || overlaps(dst + y, n, (zpg_t)(sp+1), 1)
+        || overlaps(dst + y, n, dp, 1) || overlaps(dst + y, n, (zpg_t)(dp+1), 1))
+        return idiom_single(emu, d);
+
+    cycles_t c = n * (CYCOF_lda_indr_y + CYCOF_sta_indr_y + CYCOF_iny + CYCOF_bne_rel)
+        + crossings(src, y, 0xFF) + (n-1) * (1 + PAGE_CROSSED(adr+7, adr));
+    emu->a = bulk_copy(emu, src + y, dst + y, n, 1);
+    // Y ends on 0, with the flags of the last INY
+    emu->y = 0xFF;
+    g_incr(emu, &emu->y);
+    emu->pc = adr + 7;
+    return c;
+}
+
+static cycles_t x_fill_indy(emustate* emu, const decoded* d) {
+    abs_t adr = emu->pc;
+    zpg_t dp = d->opr;
+    abs_t dst = ZPG(emu, dp) | ZPG(emu, (zpg_t)(dp+1)) << 8;
+    int y = emu->y, n = 0x100 - y;
+    if (!idiom_ready(emu, d, adr) || dst + 0xFF > 0xFFFF || overlaps(dst + y, n, adr, 5)
+        || overlaps(dst + y, n, dp, 1) || overlaps(dst + y, n, (zpg_t)(dp+1), 1))
+        return idiom_single(emu, d);
+
+    cycles_t c = n * (CYCOF_sta_indr_y + CYCOF_iny + CYCOF_bne_rel) + (n-1) * (1 + PAGE_CROSSED(adr+5, adr));
+    bulk_fill(emu, dst + y, n, emu->a, 1);
+    emu->y = 0xFF;
+    g_incr(emu, &emu->y);
+    emu->pc = adr + 5;
+    return c;
+}
+
+/*
+the X values an absolute,X loop runs with: INX goes from X up to $FF, DEX from X down to 1, except
+that X = 0 runs 0 first and then $FF down to 1
+*/
+static void x_range(emustate* emu, int up, int* first, int* n) {
+    int x = emu->x;
+    if (up) {
+        *first = x;
+        *n = 0x100 - x;
+    } else {
+        *first = x != 0;
+        *n = x != 0 ? x : 0x100;
+    }
+}
+
+/*
+X ends on 0, with the flags of the last INX or DEX
+*/
+static void x_done(emustate* emu, int up) {
+    emu->x = up ? 0xFF : 1;
+    if (up)
+        g_incr(emu, &emu->x);
+    else
+        g_decr(emu, &emu->x);
+}
+
+static cycles_t x_copy_absx(emustate* emu, const decoded* d) {
+    abs_t adr = emu->pc;
+    abs_t src = d->opr;
+    abs_t dst = peek(emu, adr+4) | peek(emu, adr+5) << 8;
+    int up = peek(emu, adr+6) == 0xE8;
+    int first, n;
+    x_range(emu, up, &first, &n);
+    if (!idiom_ready(emu, d, adr) || src + 0xFF > 0xFFFF || dst + 0xFF > 0xFFFF || overlaps(dst + first, n, adr, 9))
+        return idiom_single(emu, d);
+
+    cycles_t c = n * (CYCOF_lda_abs_x + CYCOF_sta_abs_x + CYCOF_inx + CYCOF_bne_rel)
+        + crossings(src, first, first + n-1) + (n-1) * (1 + PAGE_CROSSED(adr+9, adr));
+    if (!up && emu->x == 0) {
+        bulk_copy(emu, src, dst, 1, 1);
+        n--;
+    }
+    emu->a = bulk_copy(emu, src + (up ? emu->x : 1), dst + (up ? emu->x : 1), n, up);
+    x_done(emu, up);
+    emu->pc = adr + 9;
+    return c;
+}
+
+static cycles_t x_fill_absx(emustate* emu, const decoded* d) {
+    abs_t adr = emu->pc;
+    abs_t dst = d->opr;
+    int up = peek(emu, adr+3) == 0xE8;
+    int first, n;
+    x_range(emu, up, &first, &n);
+    if (!idiom_ready(emu, d, adr) || dst + 0xFF > 0xFFFF || overlaps(dst + first, n, adr, 6))
+        return idiom_single(emu, d);
+
+    cycles_t c = n * (CYCOF_sta_abs_x + CYCOF_inx + CYCOF_bne_rel) + (n-1) * (1 + PAGE_CROSSED(adr+6, adr));
+    if (!up && emu->x == 0) {
+        bulk_fill(emu, dst, 1, emu->a, 1);
+        n--;
+    }
+    bulk_fill(emu, dst + (up ? emu->x : 1), n, emu->a, up);
+    x_done(emu, up);
+    emu->pc = adr + 6;
+    return c;
+}
+
+/*
+the multiply runs natively one bit at a time on the same g_ functions as the instructions, so A, p and
+the flags (including V of the last ADC, and decimal mode) end as they would, without a dispatch per step
+*/
+static cycles_t x_mul_shift_add(emustate* emu, const decoded* d) {
+    abs_t adr = emu->pc;
+    zpg_t m1 = d->opr, m2 = peek(emu, adr+6), p = peek(emu, adr+9);
+    if (!idiom_ready(emu, d, adr) || overlaps(m1, 1, adr, 13) || overlaps(p, 1, adr, 13))
+        return idiom_single(emu, d);
+
+    cycles_t skip = 1 + PAGE_CROSSED(adr+4, adr+7);
+    cycles_t loop = 1 + PAGE_CROSSED(adr+13, adr);
+    cycles_t c = 0;
+    do {
+        g_lsr(emu, &ZPG(emu, m1));
+        mem_written(emu, m1);
+        if (CHECK(emu->sr, FLAG_C)) {
+            CLEAR(emu->sr, FLAG_C);
+            g_adc(emu, ZPG(emu, m2));
+            c += CYCOF_clc + CYCOF_adc_zpg;
+        } else {
+            c += skip;
+        }
+        g_ror(emu, &emu->a);
+        g_ror(emu, &ZPG(emu, p));
+        mem_written(emu, p);
+        g_decr(emu, &emu->x);
+        c += CYCOF_lsr_zpg + CYCOF_bcc_rel + CYCOF_ror_a + CYCOF_ror_zpg + CYCOF_dex + CYCOF_bne_rel;
+        if (!CHECK(emu->sr, FLAG_Z))
+            c += loop;
+    } while (!CHECK(emu->sr, FLAG_Z));
+    emu->pc = adr + 13;
+    return c;
+}
+
+static void decode_slot(const emustate* emu, decode_cache* cache, abs_t adr) {
+    decoded* d = &cache->slots[adr];
+    uint8_t opcode = peek(emu, adr);
+    const instr_info* i = instr_map[opcode];
+
+    if (i == NULL) {
+        d->exec = has_breakpoint(emu, adr) ? p_break : p_invalid;
+        d->len = 1;
+        d->key = opcode;
+        d->opr = d->opr2 = 0;
+        return;
+    }
+    if (has_breakpoint(emu, adr)) {
+        d->exec = p_break;
+        d->len = i->length;
+        d->opr = peek_operand(emu, adr, i->length);
+        d->opr2 = 0;
+        d->key = peek_key(emu, adr, d->len);
+        return;
+    }
+
+    d->exec = single_map[opcode];
+    d->len = i->length;
+    d->opr = peek_operand(emu, adr, i->length);
+    d->opr2 = 0;
+
+    int k = cache->idioms ? find_idiom(emu, adr) : -1;
+    if (k >= 0) {
+        d->exec = idioms[k].exec;
+        d->len = idioms[k].len < IDIOM_KEY ? idioms[k].len : IDIOM_KEY;
+        d->opr2 = k;
+        d->key = peek_key(emu, adr, d->len);
+        return;
+    }
+
+    abs_t next = adr + i->length;
+    const instr_info* i2 = instr_map[peek(emu, next)];
+    // pairs wrapping around the end of memory, or with a breakpoint on the second half, are left unfused
+    if (cache->fuse && i2 != NULL && next > adr && (uint32_t)next + i2->length <= 0x10000 && !has_breakpoint(emu, next)) {
+        decoded_func f = find_fusion(opcode, i2->opcode);
+        if (f != NULL) {
+            d->exec = f;
+            d->len += i2->length;
+            d->opr2 = peek_operand(emu, next, i2->length);
+        }
+    }
+
+    d->key = peek_key(emu, adr, d->len);
+}
+
+decode_cache* decode_cache_create(void) {
+    decode_cache* cache = malloc(sizeof(decode_cache));
+    if (cache == NULL)
+        return NULL;
+    cache->fuse = 1;
+    cache->idioms = 1;
+    decode_cache_flush(cache);
+    return cache;
+}
+
+void decode_cache_free(decode_cache* cache) {
+    free(cache);
+}
+
+void decode_cache_prewarm(decode_cache* cache, const emustate* emu, abs_t adr) {
+    decode_slot(emu, cache, adr);
+}
+
+void decode_cache_invalidate(decode_cache* cache, abs_t adr) {
+    // the slot at adr, and those that may hold a fused pair whose second half starts at adr
+    for (int k = 0; k <= 3; k++)
+        cache->slots[(abs_t)(adr - k)].len = 0;
+}
+
+void decode_cache_flush(decode_cache* cache) {
+    // len 0 never matches a decoded instruction, so every slot is decoded on first use
+    memset(cache->slots, 0, sizeof(cache->slots));
+}
+
+uint64_t predecode_run(emustate* emu, decode_cache* cache, uint64_t max_cycles) {
+    uint64_t total = 0;
+    // the only exit test per instruction, events end the run by lowering the budget (emu_raise)
+    emu->budget = max_cycles;
+    while (total < emu->budget) {
+        decoded* d = &cache->slots[emu->pc];
+        if (d->len == 0 || !slot_valid(emu, d, emu->pc))
+            decode_slot(emu, cache, emu->pc);
+        cycles_t c = d->exec(emu, d);
+        if (c == 0)
+            break;
+        total += c;
+    }
+    return total;
+}
+
+// profiling
+
+void pair_profile_reset(pair_profile* prof) {
+    prof->prev = -1;
+    memset(prof->counts, 0, sizeof(prof->counts));
+}
+
+void pair_profile_record(pair_profile* prof, uint8_t opcode) {
+    if (prof->prev >= 0)
+        prof->counts[prof->prev][opcode]++;
+    prof->prev = opcode;
+}
+
+void pair_profile_write(const pair_profile* prof, FILE* out, int max) {
+    // selection of the max largest counts, max is small compared to the 64K pairs
+    static uint8_t written[256][256];
+    memset(written, 0, sizeof(written));
+    for (int n = 0; n < max; n++) {
+        int best_a = -1, best_b = -1;
+        uint64_t best = 0;
+        for (int a = 0; a < 256; a++) {
+            if (instr_map[a] == NULL || !fusable_first(instr_map[a]))
+                continue;
+            for (int b = 0; b < 256; b++) {
+                if (instr_map[b] != NULL && !written[a][b] && prof->counts[a][b] > best) {
+                    best = prof->counts[a][b];
+                    best_a = a;
+                    best_b = b;
+                }
+            }
+        }
+        if (best_a < 0)
+            break;
+        written[best_a][best_b] = 1;
+        fprintf(out, "FUSE(%s, %s, %s, %s, FULL) // %llu\n",
+            handler_names[best_a], mode_names[instr_map[best_a]->mode],
+            handler_names[best_b], mode_names[instr_map[best_b]->mode],
+            (unsigned long long)best);
+    }
+}
@@ -0,0 +1,111 @@
+#ifndef PREDECODE_H
+#define PREDECODE_H
+
+#include "types.h"
+#include "emustate.h"
+
+#include <stdio.h>
+
+/*
+Predecoded dispatch
+
+Every address in memory has a slot holding the handler and operand(s) of the instruction that was
+decoded there, so running it again skips the opcode lookup and the operand fetch.
+
+A slot remembers the bytes it was decoded from and is checked against memory before it is executed,
+so self-modifying code (or the host writing into emustate.memory) simply causes the slot to be
+decoded again.
+
+A breakpoint (emu_set_breakpoint) is a slot whose handler is a trap, which stops the run or runs the
+instruction, so running without hitting one costs nothing over running without any.
+
+Common instruction pairs listed in fusion.def are decoded into a single superinstruction slot that
+runs both instructions with one dispatch. A fused slot covers the bytes of both instructions, so if
+either of them is modified the slot falls back to decoding them separately.
+
+Common loops (block copies and fills, shift-and-add multiplies, see idioms in predecode.c) are decoded
+into a slot at their first instruction that runs the whole loop at once, with the registers, flags,
+memory and cycle count it would end with. While a watch is set, a breakpoint is inside the loop, or the
+loop would store into its own code or pointers, the slot runs only the first instruction instead.
+*/
+
+struct decoded;
+
+typedef cycles_t (*decoded_func) (emustate*, const struct decoded*);
+
+typedef struct decoded {
+    decoded_func exec;
+    // bytes this slot was decoded from, little endian, first byte is the opcode
+    uint64_t key;
+    // operand of the (first) instruction
+    uint16_t opr;
+    // operand of the second instruction of a fused pair
+    uint16_t opr2;
+    // number of bytes covered by key, 0 for a slot that was never decoded
+    uint8_t len;
+} decoded;
+
+typedef struct decode_cache {
+    // non-zero to decode instruction pairs from fusion.def as superinstructions
+    int fuse;
+    // non-zero to run the loop idioms listed in predecode.c in bulk
+    int idioms;
+    decoded slots[0x10000];
+} decode_cache;
+
+/*
+return: a new cache with every slot empty and fusion and idioms enabled, or NULL if allocation failed
+*/
+decode_cache* decode_cache_create(void);
+
+void decode_cache_free(decode_cache* cache);
+
+/*
+empty every slot, e.g. after loading a new program
+*/
+void decode_cache_flush(decode_cache* cache);
+
+/*
+decode the slots that may cover adr again on their next use, e.g. after setting a breakpoint at adr
+*/
+void decode_cache_invalidate(decode_cache* cache, abs_t adr);
+
+/*
+decode the instruction at adr now rather than when it is first executed, e.g. for every
+instruction found by code_map_build (analysis.h)
+*/
+void decode_cache_prewarm(decode_cache* cache, const emustate* emu, abs_t adr);
+
+/*
+emustate* emu: the emulator/processor state
+decode_cache* cache: the cache for emu
+uint64_t max_cycles: stop once at least this many cycles have run
+return: number of cycles executed. Returns early, with PC left on the opcode, if an invalid opcode is reached,
+or after the instruction that raised a stop reason in emu->stop_mask (see emu_raise). A loop idiom counts
+as one instruction, so the run may end up to a few thousand cycles past max_cycles
+*/
+uint64_t predecode_run(emustate* emu, decode_cache* cache, uint64_t max_cycles);
+
+/*
+Opcode pair profile, used to pick the pairs listed in fusion.def
+*/
+typedef struct pair_profile {
+    // opcode of the previous instruction, -1 if none
+    int prev;
+    uint64_t counts[256][256];
+} pair_profile;
+
+void pair_profile_reset(pair_profile* prof);
+
+/*
+record that opcode was executed right after the previously recorded opcode
+*/
+void pair_profile_record(pair_profile* prof, uint8_t opcode);
+
+/*
+write the most frequent fusable pairs, most frequent first, as FUSE() lines ready for fusion.def
+int max: maximum number of pairs written
+*/
+void pair_profile_write(const pair_profile* prof, FILE* out, int max);
+
+#endif
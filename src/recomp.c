@@ -0,0 +1,147 @@
+#include "recomp.h"
+#include "addr_idx.h"
+#include "analysis.h"
+#include "disasm.h"
+#include "instr_map.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const char* handler_names[256] = {
+#define OP(opc, mn, h, mode, len, cyc, page, kind, arg, flags) [opc] = #h,
+#include "opcodes.def"
+#undef OP
+};
+
+// runtime
+
+recomp_index* recomp_index_create(const recomp_image* img) {
+    recomp_index* idx = malloc(sizeof(recomp_index));
+    if (idx == NULL)
+        return NULL;
+    memset(idx->at, 0, sizeof(idx->at));
+    for (int k = 0; k < img->n_blocks; k++)
+        idx->at[img->blocks[k].start] = &img->blocks[k];
+    return idx;
+}
+
+void recomp_index_free(recomp_index* idx) {
+    free(idx);
+}
+
+uint64_t recomp_run(emustate* emu, const recomp_index* idx, uint64_t max_cycles) {
+    uint64_t total = 0;
+    emu->budget = max_cycles;
+    while (total < emu->budget) {
+        const recomp_block* b = idx->at[emu->pc];
+        cycles_t c;
+        if (b != NULL && memcmp(emu->mem + b->start, b->bytes, b->len) == 0) {
+            c = b->run(emu);
+        } else {
+            const instr_info* i = instr_map[ADDR(emu, emu->pc)];
+            if (i == NULL) {
+                emu->stop |= STOP_INVALID;
+                break;
+            }
+            emu->pc++;
+            c = i->exec(emu);
+        }
+        total += c;
+    }
+    return total;
+}
+
+// generator
+
+/*
+return: non-zero if the handler for i reads or sets PC, which then has to be up to date when it is called
+*/
+static int uses_pc(const instr_info* i) {
+    if (i->mode == Rel)
+        return 1;
+    switch (i->opcode) {
+        case 0x00: // BRK
+        case 0x20: // JSR
+        case 0x40: // RTI
+        case 0x4C: // JMP abs
+        case 0x60: // RTS
+        case 0x6C: // JMP (ind)
+            return 1;
+    }
+    return 0;
+}
+
+/*
+number of bytes of the block that are compiled, an invalid opcode at the end is left to the interpreter
+*/
+static uint16_t compiled_len(const emustate* emu, const basic_block* b) {
+    if (instr_map[ADDR(emu, b->last)] == NULL)
+        return b->last - b->start;
+    return b->len;
+}
+
+static void write_instr(FILE* out, const emustate* emu, abs_t adr) {
+    const instr_info* i = instr_map[ADDR(emu, adr)];
+    uint8_t code[3] = {ADDR(emu, adr), ADDR(emu, adr+1), ADDR(emu, adr+2)};
+    char line[DISASM_LINE_MAX];
+    int len;
+    int n = disasm_line(code, 3, adr, line, &len);
+
+    if (uses_pc(i))
+        fprintf(out, "    emu->pc = 0x%04x;\n", (abs_t)(adr + i->length));
+    fprintf(out, "    c += i_%s(emu", handler_names[i->opcode]);
+    if (i->mode == Rel)
+        fprintf(out, ", %d", (rel_t)code[1]);
+    else if (i->length == 2)
+        fprintf(out, ", 0x%02x", code[1]);
+    else if (i->length == 3)
+        fprintf(out, ", 0x%04x", code[1] | (code[2] << 8));
+    fprintf(out, "); // %.*s\n", n - 1, line);
+}
+
+int recomp_generate(FILE* out, const emustate* emu, const code_map* map, const char* name) {
+    fprintf(out, "// generated by bin/6502rc, do not edit\n\n");
+    fprintf(out, "#include \"instructions.h\"\n#include \"recomp.h\"\n\n");
+
+    int n = 0;
+    for (int k = 0; k < map->n_blocks; k++) {
+        const basic_block* b = &map->blocks[k];
+        uint16_t len = compiled_len(emu, b);
+        // blocks wrapping around the end of memory are left to the interpreter
+        if (len == 0 || (uint32_t)b->start + len > 0x10000)
+            continue;
+        n++;
+
+        fprintf(out, "static const uint8_t k_%04x[] = {", b->start);
+        for (int j = 0; j < len; j++)
+            fprintf(out, "%s0x%02x", j ? ", " : "", ADDR(emu, b->start + j));
+        fprintf(out, "};\n\n");
+
+        fprintf(out, "static cycles_t b_%04x(emustate* emu) {\n    cycles_t c = 0;\n", b->start);
+        abs_t adr = b->start;
+        const instr_info* i = NULL;
+        while (adr != (abs_t)(b->start + len)) {
+            i = instr_map[ADDR(emu, adr)];
+            write_instr(out, emu, adr);
+            adr += i->length;
+        }
+        if (!uses_pc(i))
+            fprintf(out, "    emu->pc = 0x%04x;\n", adr);
+        fprintf(out, "    return c;\n}\n\n");
+    }
+
+    if (n == 0) {
+        fprintf(out, "static const recomp_block blocks[1];\n\nconst recomp_image %s = {0, blocks};\n", name);
+        return ferror(out) ? -1 : 0;
+    }
+    fprintf(out, "static const recomp_block blocks[] = {\n");
+    for (int k = 0; k < map->n_blocks; k++) {
+        const basic_block* b = &map->blocks[k];
+        uint16_t len = compiled_len(emu, b);
+        if (len == 0 || (uint32_t)b->start + len > 0x10000)
+            continue;
+        fprintf(out, "    {0x%04x, %u, k_%04x, b_%04x},\n", b->start, len, b->start, b->start);
+    }
+    fprintf(out, "};\n\nconst recomp_image %s = {%d, blocks};\n", name, n);
+    return ferror(out) ? -1 : 0;
+}
@@ -0,0 +1,79 @@
+#ifndef RECOMP_H
+#define RECOMP_H
+
+#include "types.h"
+#include "emustate.h"
+
+#include <stdio.h>
+
+struct code_map;
+
+/*
+Ahead-of-time recompilation of a ROM to C
+
+bin/6502rc finds the basic blocks of a ROM (analysis.h) and writes one C file with a function per
+block. Each function calls the instruction handlers (i_adc_imd etc., and through them the g_
+semantics in instructions.c) directly with constant operands, so there is no fetch, decode or
+dispatch inside a block. Built against the library archive, that dispatch is all a block saves; to
+optimize across guest instructions, compile the generated file together with the library sources
+under -O2 -flto, as bin/recomp_test is, so the handlers are inlined and cycle counts fold to constants.
+
+The generated file defines a recomp_image, which recomp_run executes. Every block remembers the
+bytes it was compiled from and is only used while memory still holds them; code that was modified
+or was not found by the analysis runs in the interpreter instead.
+
+An index set in emustate.recomp makes emu_run and emu_run_until (lib6502emu.h) run the blocks, in
+slices like the other dispatches, so host stops, the slice hook and with it the debug server
+(debug_server.h) work as usual, and watches stop at the end of the block that hit them. Breakpoints cannot be trapped inside a block: while any are
+set, emu_run_until runs the plain interpreter instead.
+*/
+
+/*
+runs a whole block: returns its cycles, with PC on the next instruction to run
+*/
+typedef cycles_t (*recomp_func) (emustate*);
+
+typedef struct recomp_block {
+    abs_t start;
+    uint16_t len;
+    // the bytes the block was compiled from
+    const uint8_t* bytes;
+    recomp_func run;
+} recomp_block;
+
+typedef struct recomp_image {
+    int n_blocks;
+    const recomp_block* blocks;
+} recomp_image;
+
+/*
+start address -> block, built once per image
+*/
+typedef struct recomp_index {
+    const recomp_block* at[0x10000];
+} recomp_index;
+
+/*
+return: a new index of img, or NULL if allocation failed
+*/
+recomp_index* recomp_index_create(const recomp_image* img);
+
+void recomp_index_free(recomp_index* idx);
+
+/*
+run like predecode_run, using the compiled block at PC when there is one and its bytes are unchanged,
+the interpreter otherwise. Stop reasons (see emu_raise) raised inside a block take effect when the
+block ends, and code a block modifies in itself takes effect the next time the block is entered
+return: number of cycles executed, returns early with PC left on the opcode if an invalid opcode is reached
+*/
+uint64_t recomp_run(emustate* emu, const recomp_index* idx, uint64_t max_cycles);
+
+/*
+write the C source for every block in map
+const emustate* emu: memory holding the ROM that map was built from
+const char* name: name of the recomp_image defined by the file
+return: 0, or -1 if writing failed
+*/
+int recomp_generate(FILE* out, const emustate* emu, const struct code_map* map, const char* name);
+
+#endif
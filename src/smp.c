@@ -0,0 +1,208 @@
+#include "smp.h"
+#include "addr_idx.h"
+#include "lib6502emu.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+write log entries one CPU may need in a quantum: every write takes at least a cycle, and a run
+overshoots its budget by less than the cycles of one slot
+*/
+#define LOG_CAP(quantum) ((quantum) + 0x10000)
+
+typedef struct worker {
+    struct smp_system* sys;
+    int k;
+} worker;
+
+struct smp_system {
+    int n;
+    uint64_t quantum;
+    emustate* cpus[SMP_MAX_CPUS];
+    pthread_t threads[SMP_MAX_CPUS];
+    worker workers[SMP_MAX_CPUS];
+    int n_threads;
+    // the threads wait for started before their first barrier, quit is set to end them
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    int started;
+    int quit;
+    // go: the caller and every thread, at the start and the end of smp_run
+    // ran, merged: the threads, after running a quantum and after merging the logs
+    pthread_barrier_t go, ran, merged;
+    // system clock, and where the current smp_run ends
+    uint64_t now;
+    uint64_t end;
+    // per CPU, set if it is on an invalid opcode
+    int halted[SMP_MAX_CPUS];
+    int running;
+};
+
+/*
+apply the logs of every CPU, in CPU order, to the memory of CPU k
+*/
+static void merge(smp_system* sys, int k) {
+    emustate* cpu = sys->cpus[k];
+    for (int j = 0; j < sys->n; j++) {
+        const emustate* from = sys->cpus[j];
+        for (uint32_t i = 0; i < from->log_len; i++)
+            emu_write(cpu, from->write_log[i] >> 8, from->write_log[i] & 0xFF);
+    }
+}
+
+/*
+the quanta of one smp_run, on the thread of CPU k
+*/
+static void run_quanta(smp_system* sys, int k) {
+    emustate* cpu = sys->cpus[k];
+    uint64_t t = sys->now;
+    int running = sys->n;
+    while (t < sys->end && running > 0) {
+        uint64_t target = (t / sys->quantum + 1) * sys->quantum;
+        if (target > sys->end)
+            target = sys->end;
+        if (cpu->cycles < target) {
+            emu_run(cpu, target - cpu->cycles);
+            sys->halted[k] = (cpu->stop & STOP_INVALID) != 0;
+            // a CPU on an invalid opcode waits there, keeping up with the clock
+            if (sys->halted[k])
+                cpu->cycles = target;
+        }
+        pthread_barrier_wait(&sys->ran);
+        merge(sys, k);
+        running = 0;
+        for (int j = 0; j < sys->n; j++)
+            running += !sys->halted[j];
+        pthread_barrier_wait(&sys->merged);
+        cpu->log_len = 0;
+        t = target;
+    }
+    if (k == 0) {
+        sys->now = t;
+        sys->running = running;
+    }
+}
+
+static void* thread_main(void* arg) {
+    worker* w = arg;
+    smp_system* sys = w->sys;
+    pthread_mutex_lock(&sys->lock);
+    while (!sys->started)
+        pthread_cond_wait(&sys->start, &sys->lock);
+    int quit = sys->quit;
+    pthread_mutex_unlock(&sys->lock);
+    if (quit)
+        return NULL;
+    while (1) {
+        pthread_barrier_wait(&sys->go);
+        if (sys->quit)
+            return NULL;
+        run_quanta(sys, w->k);
+        pthread_barrier_wait(&sys->go);
+    }
+}
+
+/*
+let the threads past their start, to run or, with quit set, to end
+*/
+static void start_threads(smp_system* sys) {
+    pthread_mutex_lock(&sys->lock);
+    sys->started = 1;
+    pthread_cond_broadcast(&sys->start);
+    pthread_mutex_unlock(&sys->lock);
+}
+
+smp_system* smp_create(int n_cpus, uint64_t quantum) {
+    if (n_cpus < 1 || n_cpus > SMP_MAX_CPUS || quantum == 0)
+        return NULL;
+    smp_system* sys = calloc(1, sizeof(smp_system));
+    if (sys == NULL)
+        return NULL;
+    sys->n = n_cpus;
+    sys->quantum = quantum;
+    pthread_mutex_init(&sys->lock, NULL);
+    pthread_cond_init(&sys->start, NULL);
+    pthread_barrier_init(&sys->go, NULL, n_cpus + 1);
+    pthread_barrier_init(&sys->ran, NULL, n_cpus);
+    pthread_barrier_init(&sys->merged, NULL, n_cpus);
+    for (int k = 0; k < n_cpus; k++) {
+        emustate* cpu = emu_create();
+        sys->cpus[k] = cpu;
+        if (cpu == NULL)
+            break;
+        cpu->write_log = malloc(LOG_CAP(quantum) * sizeof(uint32_t));
+        if (cpu->write_log == NULL)
+            break;
+        cpu->log_cap = LOG_CAP(quantum);
+        cpu->write_hooks |= HOOK_LOG;
+        sys->workers[k] = (worker){sys, k};
+        if (pthread_create(&sys->threads[k], NULL, thread_main, &sys->workers[k]) != 0)
+            break;
+        sys->n_threads++;
+    }
+    if (sys->n_threads < n_cpus) {
+        smp_free(sys);
+        return NULL;
+    }
+    start_threads(sys);
+    return sys;
+}
+
+void smp_free(smp_system* sys) {
+    if (sys == NULL)
+        return;
+    sys->quit = 1;
+    if (sys->started)
+        pthread_barrier_wait(&sys->go);
+    else
+        start_threads(sys);
+    for (int k = 0; k < sys->n_threads; k++)
+        pthread_join(sys->threads[k], NULL);
+    for (int k = 0; k < sys->n; k++) {
+        if (sys->cpus[k] == NULL)
+            continue;
+        free(sys->cpus[k]->write_log);
+        emu_destroy(sys->cpus[k]);
+    }
+    pthread_barrier_destroy(&sys->go);
+    pthread_barrier_destroy(&sys->ran);
+    pthread_barrier_destroy(&sys->merged);
+    pthread_cond_destroy(&sys->start);
+    pthread_mutex_destroy(&sys->lock);
+    free(sys);
+}
+
+emustate* smp_cpu(smp_system* sys, int k) {
+    return k >= 0 && k < sys->n ? sys->cpus[k] : NULL;
+}
+
+void smp_share(smp_system* sys, int first_page, int last_page) {
+    for (int k = 0; k < sys->n; k++) {
+        for (int page = first_page; page <= last_page && page < 256; page++)
+            sys->cpus[k]->shared[page >> 3] |= 1 << (page & 7);
+    }
+}
+
+void smp_load(smp_system* sys, abs_t adr, const uint8_t* data, size_t len) {
+    for (int k = 0; k < sys->n; k++)
+        emu_load(sys->cpus[k], adr, data, len);
+}
+
+void smp_write(smp_system* sys, abs_t adr, uint8_t value) {
+    for (int k = 0; k < sys->n; k++)
+        emu_write(sys->cpus[k], adr, value);
+}
+
+int smp_run(smp_system* sys, uint64_t cycles) {
+    sys->end = sys->now + cycles;
+    // the barriers order these writes before the threads read them, and theirs before the return
+    pthread_barrier_wait(&sys->go);
+    pthread_barrier_wait(&sys->go);
+    return sys->running;
+}
+
+uint64_t smp_clock(const smp_system* sys) {
+    return sys->now;
+}
@@ -0,0 +1,78 @@
+#ifndef SMP_H
+#define SMP_H
+
+#include "types.h"
+#include "emustate.h"
+
+#include <stddef.h>
+
+/*
+Multi-CPU systems
+
+Several CPUs, each an emustate of its own with its own memory and predecode cache, run in parallel on
+host threads for a quantum of cycles at a time and synchronize at quantum boundaries.
+
+Pages marked shared (smp_share) are where the CPUs see each other's writes. During a quantum every
+CPU writes only its own copy of memory, and its instructions' writes to shared pages are appended to
+its write log (HOOK_LOG). At the boundary the logs are merged into every CPU's copy, CPU 0's log
+first, so when two CPUs write the same address in a quantum, the higher numbered CPU's write wins.
+A CPU therefore sees another CPU's writes from the next quantum on, never in the middle of one.
+
+Each CPU's run within a quantum depends only on its own state, and the merge order is fixed, so the
+result depends on the programs, the quantum and the smp_run calls only, not on how the host
+schedules the threads. Quantum boundaries are at multiples of the quantum in the system clock, which
+is the cycle count of the CPUs; a CPU that overshoots a boundary runs that much less in the next
+quantum. The end of every smp_run call is a boundary as well.
+
+Only writes made by instructions are logged: the host writes shared memory with smp_write, and HLE
+functions (emu_set_hle) should write to private pages only.
+*/
+
+#define SMP_MAX_CPUS 16
+
+typedef struct smp_system smp_system;
+
+/*
+int n_cpus: number of CPUs, 1 to SMP_MAX_CPUS, each reset and with nothing shared
+uint64_t quantum: cycles between synchronizations, smaller is closer to real concurrent CPUs, larger runs faster
+return: the system with a host thread per CPU, or NULL if allocation or thread creation failed
+*/
+smp_system* smp_create(int n_cpus, uint64_t quantum);
+
+/*
+stop the threads and free the system and its CPUs
+*/
+void smp_free(smp_system* sys);
+
+/*
+return: CPU k, to load its program and set its registers (emu_load, emu_set_reg) between runs.
+Its cycle count follows the system clock and must not be changed
+*/
+emustate* smp_cpu(smp_system* sys, int k);
+
+/*
+share pages first_page to last_page (inclusive) between all CPUs, each keeps its current contents
+*/
+void smp_share(smp_system* sys, int first_page, int last_page);
+
+/*
+write to memory of every CPU, e.g. to load shared data or code all CPUs run
+*/
+void smp_load(smp_system* sys, abs_t adr, const uint8_t* data, size_t len);
+
+void smp_write(smp_system* sys, abs_t adr, uint8_t value);
+
+/*
+run every CPU for the given number of cycles of the system clock, a quantum at a time. A CPU that
+reaches an invalid opcode waits there (PC is left on it) while the others go on, and runs again
+once the host moves its PC
+return: number of CPUs that are not on an invalid opcode, the run ends early once that is 0
+*/
+int smp_run(smp_system* sys, uint64_t cycles);
+
+/*
+return: the system clock, cycles run since smp_create
+*/
+uint64_t smp_clock(const smp_system* sys);
+
+#endif
@@ -40,6 +40,23 @@ enum instruction_type {
     Implied, Relative, Zeropage, Absolute, Immediate, Indirect
 };
 
+/*
+addressing mode, finer grained than instruction_type (which only decides the handler signature)
+see the naming convention in instructions.h
+*/
+enum addr_mode {
+    Impl, Acc, Imd, Zpg, ZpgX, ZpgY, Abs, AbsX, AbsY, Ind, IndX, IndY, Rel, MODE_COUNT
+};
+
+/*
+extra cycles an instruction may take on top of its base cycle count
+*/
+enum page_rule {
+    PX_NONE,    // fixed cycle count
+    PX_PAGE,    // +1 if indexing crosses a page boundary
+    PX_BRANCH   // +1 if branch is taken, +2 if taken to a different page
+};
+
 union instruction_func {
     cycles_t (*absolute) (emustate*, abs_t);
     cycles_t (*immediate) (emustate*, imd_t);
@@ -54,6 +71,26 @@ typedef struct instr_info {
     const uint8_t opcode;
     const enum instruction_type type;
     const union instruction_func fptr;
+    const enum addr_mode mode;
+    // total length in bytes, including the opcode
+    const uint8_t length;
+    // base cycle count
+    const uint8_t cycles;
+    const enum page_rule page;
+    // F_* flags written by the instruction
+    const uint8_t flags;
+    // fetches the operand at PC and calls fptr with the right signature
+    cycles_t (*const exec) (emustate*);
 } instr_info;
 
+/*
+addressing mode syntax, used to print operands
+*/
+typedef struct mode_info {
+    const char* prefix;
+    const char* suffix;
+    // number of operand bytes following the opcode
+    const uint8_t operand_len;
+} mode_info;
+
 #endif
\ No newline at end of file
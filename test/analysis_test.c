@@ -0,0 +1,77 @@
+#include <assert.h>
+#include <stdio.h>
+
+#include "analysis.h"
+#include "asm.h"
+#include "lib6502emu.h"
+#include "predecode.h"
+
+int main() {
+    static emustate emu;
+    emustate* e = &emu;
+    emu_init(e);
+
+    const char* rom =
+        "        .org $f000\n"
+        "reset:  LDX #3\n"          // f000
+        "loop:   JSR sub\n"         // f002
+        "        DEX\n"             // f005
+        "        BNE loop\n"        // f006
+        "        JMP (vec)\n"       // f008
+        "sub:    LDA table,X\n"     // f00b
+        "        RTS\n"             // f00e
+        "table:  .byte 1, 2, 3, 4\n"// f00f
+        "nmi:    RTI\n"             // f013
+        "vec:    .word reset\n"     // f014
+        "        .org $fffa\n"
+        "        .word nmi, reset, nmi\n";
+    assert(asm_assemble(e, rom, 0, NULL) == 0);
+
+    code_map* map = code_map_create();
+    assert(map != NULL);
+    assert(code_map_build_vectors(map, e, NULL, 0) == 0);
+
+    assert(map->kind[0xF000] == MAP_OPCODE && map->kind[0xF001] == MAP_OPERAND);
+    assert(map->kind[0xF00E] == MAP_OPCODE);
+    for (abs_t adr = 0xF00F; adr <= 0xF012; adr++)
+        assert(map->kind[adr] == MAP_DATA);
+    assert(map->kind[0xF013] == MAP_OPCODE);
+    assert(map->kind[0xF014] == MAP_DATA && map->kind[0xFFFC] == MAP_DATA);
+    assert(map->conflicts == 0);
+
+    const struct {abs_t start; uint16_t len; enum block_exit exit; int32_t next, target;} expect[] = {
+        {0xF000, 2, EXIT_FALL,     0xF002, -1},
+        {0xF002, 3, EXIT_CALL,     0xF005, 0xF00B},
+        {0xF005, 3, EXIT_BRANCH,   0xF008, 0xF002},
+        {0xF008, 3, EXIT_INDIRECT, -1,     -1},
+        {0xF00B, 4, EXIT_RETURN,   -1,     -1},
+        {0xF013, 1, EXIT_RETURN,   -1,     -1},
+    };
+    assert(map->n_blocks == sizeof(expect)/sizeof(expect[0]));
+    for (int k = 0; k < map->n_blocks; k++) {
+        const basic_block* b = &map->blocks[k];
+        assert(b->start == expect[k].start && b->len == expect[k].len && b->exit == expect[k].exit);
+        assert(b->next == expect[k].next && b->target == expect[k].target);
+        assert(code_map_find_block(map, b->start) == k);
+    }
+    assert(code_map_find_block(map, 0xF001) == -1);
+
+    // prewarming decodes the code and nothing else
+    decode_cache* cache = decode_cache_create();
+    code_map_prewarm(map, e, cache);
+    assert(cache->slots[0xF000].len != 0 && cache->slots[0xF013].len != 0);
+    assert(cache->slots[0xF001].len == 0 && cache->slots[0xF00F].len == 0);
+    decode_cache_free(cache);
+
+    // a jump into the middle of an instruction only sees the bytes it executes
+    emu_reset(e);
+    assert(asm_assemble(e, "JMP skip+1\nskip: LDA #$ea\nBRK", 0x4000, NULL) == 0);
+    abs_t entry = 0x4000;
+    assert(code_map_build(map, e, &entry, 1) == 0);
+    assert(map->kind[0x4004] == MAP_OPCODE && map->kind[0x4003] == MAP_DATA);
+    assert(map->n_blocks == 2 && map->blocks[1].start == 0x4004 && map->blocks[1].exit == EXIT_STOP);
+
+    code_map_free(map);
+    printf("All tests passed.\n");
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "addr_idx.h"
+#include "asm.h"
+#include "emustate.h"
+#include "instr_map.h"
+#include "lib6502emu.h"
+
+/*
+assemble one line at $4000 and check the bytes written
+*/
+void check_line(emustate* emu, const char* line, const uint8_t* bytes, int len) {
+    asm_result res;
+    int r = asm_assemble(emu, line, 0x4000, &res);
+    if (r != 0)
+        printf("%s: line %d: %s\n", line, res.error_line, res.error);
+    assert(r == 0);
+    assert(res.start == 0x4000 && res.size == len && res.end == 0x4000 + len);
+    assert(memcmp(&ADDR(emu, 0x4000), bytes, len) == 0);
+}
+
+int main() {
+    static emustate emu;
+    emustate* e = &emu;
+    emu_init(e);
+
+    // every opcode in instr_map, written the way mode_map prints it
+    for (int opc = 0; opc < 256; opc++) {
+        const instr_info* i = instr_map[opc];
+        if (i == NULL)
+            continue;
+        const mode_info* m = &mode_map[i->mode];
+        char line[32];
+        uint8_t bytes[3] = {opc, 0x12, 0x34};
+        if (i->mode == Rel) {
+            snprintf(line, sizeof(line), "%s $4010", i->name);
+            bytes[1] = 0x0E;
+        } else if (m->operand_len == 2) {
+            snprintf(line, sizeof(line), "%s %s3412%s", i->name, m->prefix, m->suffix);
+        } else if (m->operand_len == 1) {
+            snprintf(line, sizeof(line), "%s %s12%s", i->name, m->prefix, m->suffix);
+        } else {
+            snprintf(line, sizeof(line), "%s %s", i->name, m->prefix);
+        }
+        check_line(e, line, bytes, i->length);
+    }
+
+    // syntax details
+    check_line(e, "  lda ( $10 ),y ; comment", (const uint8_t[]){0xB1, 0x10}, 2);
+    check_line(e, "LDA $0010", (const uint8_t[]){0xA5, 0x10}, 2); //value fits, so zero page
+    check_line(e, "LDA later\nlater = $10", (const uint8_t[]){0xAD, 0x10, 0x00}, 3); //forward, so absolute
+    check_line(e, "LDA #<$1234+1", (const uint8_t[]){0xA9, 0x35}, 2);
+    check_line(e, "LDA #>$1234", (const uint8_t[]){0xA9, 0x12}, 2);
+    check_line(e, "LDA (2+3)*4", (const uint8_t[]){0xA5, 20}, 2);
+    check_line(e, "JMP (v)\nv: .word *, 1<<8|%11, -1", (const uint8_t[]){0x6C, 0x03, 0x40, 0x03, 0x40, 0x03, 0x01, 0xFF, 0xFF}, 9);
+    check_line(e, ".byte \"a;b\", 'c', -1 ; x", (const uint8_t[]){'a', ';', 'b', 'c', 0xFF}, 5);
+
+    // a program using labels, assembled and run
+    const char* prog =
+        "        .org $4000\n"
+        "count = 5\n"
+        "start:  LDX #count\n"
+        "        LDA #0\n"
+        "loop:   CLC\n"
+        "        ADC table-1,X\n"
+        "        DEX\n"
+        "        BNE loop\n"
+        "        STA result\n"
+        "        BRK\n"
+        "table:  .byte 1, 2, 3, 4, 5\n"
+        "result: .byte 0\n";
+    asm_result res;
+    assert(asm_assemble(e, prog, 0, &res) == 0);
+    assert(res.start == 0x4000 && res.end == 0x4015);
+    e->pc = res.start;
+    assert(emu_run_until(e, 1000, STOP_BRK) == STOP_BRK);
+    assert(ADDR(e, 0x4014) == 15);
+
+    // native_code/test1.asm
+    check_line(e, "LDA #$01\nADC #$20\nPHA\nJSR $1000", (const uint8_t[]){0xA9, 0x01, 0x69, 0x20, 0x48, 0x20, 0x00, 0x10}, 8);
+
+    // errors are reported with their line
+    assert(asm_assemble(e, "NOP\nLDA nowhere", 0, &res) == -1);
+    assert(res.error_line == 2 && strstr(res.error, "nowhere") != NULL);
+    assert(asm_assemble(e, "BNE far\n.org $5000\nfar:", 0x4000, &res) == -1);
+    assert(res.error_line == 1);
+    assert(asm_assemble(e, "LDX $10,X", 0, &res) == -1);
+    assert(asm_assemble(e, "FOO", 0, &res) == -1);
+    assert(asm_assemble(e, "a: NOP\na: NOP", 0, &res) == -1 && res.error_line == 2);
+    assert(asm_assemble(e, "LDA #$100", 0, &res) == -1);
+
+    // assembled bytes are marked dirty, so a reset clears them
+    emu_reset(e);
+    emu_track_dirty(e, 1);
+    assert(asm_assemble(e, "LDA #1\n.org $C000\n.byte 1, 2, 3", 0x4000, &res) == 0);
+    assert(ADDR(e, 0x4000) == 0xA9 && ADDR(e, 0xC002) == 3);
+    emu_reset(e);
+    for (int adr = 0; adr < 0x10000; adr++)
+        assert(ADDR(e, adr) == 0);
+
+    printf("All tests passed.\n");
+    return 0;
+}
@@ -0,0 +1,143 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "addr_idx.h"
+#include "asm.h"
+#include "buscore.h"
+#include "difftest.h"
+#include "lib6502emu.h"
+
+typedef struct trace {
+    int n;
+    abs_t adr[16];
+    uint8_t val[16];
+    int kind[16];
+} trace;
+
+static void record(emustate* emu, abs_t adr, uint8_t value, int kind, void* ctx) {
+    trace* t = ctx;
+    assert(t->n < 16);
+    t->adr[t->n] = adr;
+    t->val[t->n] = value;
+    t->kind[t->n] = kind;
+    t->n++;
+}
+
+/*
+run the instruction at $4000 and check its bus cycles against want, n entries of {adr, value, kind}
+*/
+static void check_cycles(emustate* emu, trace* t, const int want[][3], int n) {
+    emu->pc = 0x4000;
+    t->n = 0;
+    assert(emu_step(emu) == n);
+    assert(t->n == n);
+    for (int k = 0; k < n; k++)
+        assert(t->adr[k] == want[k][0] && t->val[k] == want[k][1] && t->kind[k] == want[k][2]);
+}
+
+int main() {
+    emustate* emu = emu_create();
+    assert(emu != NULL);
+    assert(emu_set_core(emu, EMU_CORE_BUS) == 0 && emu->bus != NULL);
+    trace t;
+    bus_set_hook(emu, record, &t);
+
+    // LDA $12FF,X crossing a page: a dummy read before the high byte is fixed up
+    const uint8_t lda[] = {0xBD, 0xFF, 0x12};
+    emu_load(emu, 0x4000, lda, sizeof(lda));
+    emu_write(emu, 0x1300, 0x77);
+    emu->x = 1;
+    const int lda_cycles[][3] = {
+        {0x4000, 0xBD, BUS_SYNC}, {0x4001, 0xFF, 0}, {0x4002, 0x12, 0}, {0x1200, 0x00, BUS_DUMMY}, {0x1300, 0x77, 0},
+    };
+    check_cycles(emu, &t, lda_cycles, 5);
+    assert(emu->a == 0x77 && emu->pc == 0x4003);
+
+    // INC $10: read, write the old value back, write the result
+    const uint8_t inc[] = {0xE6, 0x10};
+    emu_load(emu, 0x4000, inc, sizeof(inc));
+    emu_write(emu, 0x0010, 0x41);
+    const int inc_cycles[][3] = {
+        {0x4000, 0xE6, BUS_SYNC}, {0x4001, 0x10, 0}, {0x0010, 0x41, 0}, {0x0010, 0x41, BUS_WRITE | BUS_DUMMY},
+        {0x0010, 0x42, BUS_WRITE},
+    };
+    check_cycles(emu, &t, inc_cycles, 5);
+
+    // a taken branch to another page reads twice before landing
+    const uint8_t bne[] = {0xD0, 0xFD};
+    emu_load(emu, 0x4000, bne, sizeof(bne));
+    emu->sr = 0;
+    const int bne_cycles[][3] = {
+        {0x4000, 0xD0, BUS_SYNC}, {0x4001, 0xFD, 0}, {0x4002, 0x12, BUS_DUMMY}, {0x40FF, 0x00, BUS_DUMMY},
+    };
+    check_cycles(emu, &t, bne_cycles, 4);
+    assert(emu->pc == 0x3FFF);
+
+    // a run can end in the middle of an instruction and pick up from there
+    emu->pc = 0x4000;
+    t.n = 0;
+    assert(emu_run(emu, 2) == 2 && !bus_idle(emu) && emu->pc == 0x4002);
+    assert(emu_run(emu, 2) == 2 && bus_idle(emu) && emu->pc == 0x3FFF && t.n == 4);
+
+    // both cores end every instruction of a program in the same state, with the same writes
+    const char* src =
+        "        LDX #5\n"
+        "        LDA #$20\n"
+        "        STA $80\n"
+        "        LDA #$03\n"
+        "        STA $81\n"
+        "loop:   TXA\n"
+        "        PHA\n"
+        "        LDY #$F0\n"
+        "        STA ($80),Y\n"
+        "        LDA ($7F,X)\n"
+        "        STA $0300,X\n"
+        "        ASL $0300,X\n"
+        "        ROR A\n"
+        "        INC $40,X\n"
+        "        ADC $03F5,Y\n"
+        "        JSR sub\n"
+        "        PLA\n"
+        "        DEX\n"
+        "        BNE loop\n"
+        "        JMP done\n"
+        "sub:    CMP #$10\n"
+        "        BCC skip\n"
+        "        SBC #1\n"
+        "skip:   RTS\n"
+        "done:   NOP\n"
+        "        .byte $02\n";
+    static emustate start;
+    emu_init(&start);
+    assert(asm_assemble(&start, src, 0x4000, NULL) == 0);
+    start.pc = 0x4000;
+    diff_result res;
+    assert(diff_run(&start, diff_step_interp, diff_step_bus, UINT64_MAX, &res) == 0);
+    assert(!res.diverged && res.invalid && res.instructions > 50);
+    diff_result_free(&res);
+
+    // stops: breakpoints before the instruction, watches after it, on the bus core too
+    bus_set_hook(emu, NULL, NULL);
+    emu_reset(emu);
+    assert(asm_assemble(emu, src, 0x4000, NULL) == 0);
+    emu->pc = 0x4000;
+    emu_set_breakpoint(emu, 0x400A, 1);
+    assert(emu_run_until(emu, 1000, STOP_BREAKPOINT) == STOP_BREAKPOINT && emu->pc == 0x400A && bus_idle(emu));
+    emu_set_breakpoint(emu, 0x400A, 0);
+    emu_set_watch(emu, 0x0305, WATCH_WRITE);
+    assert(emu_run_until(emu, 1000, STOP_WATCH) == STOP_WATCH && emu->watch_hit == 0x0305 && bus_idle(emu));
+    emu_set_watch(emu, 0x0305, 0);
+    assert(emu_run_until(emu, 100000, 0) == STOP_INVALID);
+
+    // back to the instruction core, an instruction in flight is completed first
+    emu->pc = 0x4000;
+    emu_run(emu, 1);
+    uint64_t cycles = emu->cycles;
+    assert(emu_set_core(emu, EMU_CORE_INSTR) == 0 && emu->bus == NULL);
+    assert(emu->pc == 0x4002 && emu->cycles == cycles + 1);
+    emu_destroy(emu);
+
+    printf("All tests passed.\n");
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "debug_server.h"
+#include "lib6502emu.h"
+
+static emustate* emu;
+
+static void* run(void* arg) {
+    emu_run_until(emu, UINT64_MAX, STOP_HOST);
+    return NULL;
+}
+
+/*
+send a command and read its reply up to and including the final "ok" or "error" line
+*/
+static void ask(int fd, const char* cmd, char* out, int size) {
+    assert(write(fd, cmd, strlen(cmd)) == strlen(cmd));
+    int len = 0;
+    while (1) {
+        ssize_t n = read(fd, out + len, size - 1 - len);
+        assert(n > 0);
+        len += n;
+        out[len] = 0;
+        if (out[len - 1] != '\n')
+            continue;
+        if ((len >= 3 && strcmp(out + len - 3, "ok\n") == 0) || strstr(out, "error:") != NULL)
+            return;
+    }
+}
+
+static unsigned long long cycles_of(const char* regs) {
+    const char* c = strstr(regs, "cycles=");
+    assert(c != NULL);
+    return strtoull(c + 7, NULL, 10);
+}
+
+int main() {
+    const uint8_t loop[] = {
+        0xA2, 0x00,       // LDX #0
+        0xE8,             // INX
+        0x8E, 0x00, 0x02, // STX $0200
+        0x4C, 0x02, 0x40, // JMP $4002
+    };
+    emu = emu_create();
+    assert(emu != NULL);
+    emu_load(emu, 0x4000, loop, sizeof(loop));
+    emu_set_reg(emu, REG_PC, 0x4000);
+
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/6502emu_debug_test.%d", (int)getpid());
+    debug_server* srv = debug_server_start(path, emu);
+    assert(srv != NULL);
+    pthread_t t;
+    assert(pthread_create(&t, NULL, run, NULL) == 0);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un sa = {.sun_family = AF_UNIX};
+    strcpy(sa.sun_path, path);
+    assert(connect(fd, (struct sockaddr*)&sa, sizeof(sa)) == 0);
+
+    // registers and memory are read while the loop keeps running
+    static char out[0x8000];
+    unsigned long long c1 = 0, c2;
+    while (c1 == 0) {
+        ask(fd, "regs\n", out, sizeof(out));
+        assert(strstr(out, "running") != NULL);
+        c1 = cycles_of(out);
+    }
+    ask(fd, "mem 4000 9\n", out, sizeof(out));
+    assert(strcmp(out, "4000: a2 00 e8 8e 00 02 4c 02 40\nok\n") == 0);
+    ask(fd, "mem 0200 4096\n", out, sizeof(out));
+    assert(strncmp(out, "0200: ", 6) == 0 && strstr(out, "\n11f0:") != NULL);
+    ask(fd, "mem 10000\n", out, sizeof(out));
+    assert(strncmp(out, "error:", 6) == 0);
+    ask(fd, "bogus\n", out, sizeof(out));
+    assert(strncmp(out, "error:", 6) == 0);
+
+    // halted, the cycle count and memory stay put until cont
+    ask(fd, "halt\n", out, sizeof(out));
+    assert(strcmp(out, "ok\n") == 0);
+    ask(fd, "regs\n", out, sizeof(out));
+    assert(strstr(out, "halted") != NULL);
+    c1 = cycles_of(out);
+    usleep(20000);
+    ask(fd, "regs\n", out, sizeof(out));
+    c2 = cycles_of(out);
+    assert(c1 == c2);
+    char x[8];
+    snprintf(x, sizeof(x), "%02x", emu_read(emu, 0x0200));
+    ask(fd, "mem 200 1\n", out, sizeof(out));
+    assert(strncmp(out + 6, x, 2) == 0);
+    ask(fd, "cont\n", out, sizeof(out));
+    do {
+        ask(fd, "regs\n", out, sizeof(out));
+    } while (cycles_of(out) == c2);
+
+    ask(fd, "stop\n", out, sizeof(out));
+    pthread_join(t, NULL);
+    ask(fd, "quit\n", out, sizeof(out));
+    close(fd);
+    debug_server_stop(srv);
+    assert(access(path, F_OK) != 0);
+    assert(emu->slice_hook == NULL);
+    emu_destroy(emu);
+
+    printf("All tests passed.\n");
+    return 0;
+}
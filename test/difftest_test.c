@@ -0,0 +1,77 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "addr_idx.h"
+#include "asm.h"
+#include "difftest.h"
+#include "lib6502emu.h"
+
+/*
+the interpreter with a bug: stores one byte too many after the instruction at $4004
+*/
+static cycles_t step_bad_store(emustate* emu) {
+    abs_t pc = emu->pc;
+    cycles_t c = emu_step(emu);
+    if (pc == 0x4004)
+        mem_write(emu, 0x0300, 0xAA);
+    return c;
+}
+
+/*
+the interpreter with a bug: INX leaves X alone
+*/
+static cycles_t step_bad_inx(emustate* emu) {
+    uint8_t x = emu->x;
+    uint8_t opcode = ADDR(emu, emu->pc);
+    cycles_t c = emu_step(emu);
+    if (opcode == 0xE8)
+        emu->x = x;
+    return c;
+}
+
+int main() {
+    static emustate emu;
+    emustate* e = &emu;
+    emu_init(e);
+    const char* src =
+        "        LDX #5\n"
+        "loop:   LDA #1\n"      // 4002
+        "        STA $10,X\n"
+        "        LDA $10,X\n"
+        "        STA $0200,X\n"
+        "        DEX\n"          // fused with the BNE
+        "        BNE loop\n"
+        "        INX\n"
+        "        .byte $02\n";
+    assert(asm_assemble(e, src, 0x4000, NULL) == 0);
+    e->pc = 0x4000;
+
+    // the interpreter and the predecoded dispatch agree, including on fused pairs
+    diff_result res;
+    assert(diff_run(e, diff_step_interp, diff_step_predecode, UINT64_MAX, &res) == 0);
+    assert(!res.diverged && res.invalid);
+    assert(res.instructions == 1 + 5*6 + 1);
+    assert(res.a->pc == res.b->pc && ADDR(res.b, 0x0201) == 1 && res.a->x == 1);
+    diff_result_free(&res);
+
+    // a cycle limit ends the run early
+    assert(diff_run(e, diff_step_interp, diff_step_predecode, 10, &res) == 0);
+    assert(!res.diverged && !res.invalid && res.cycles >= 10);
+    diff_result_free(&res);
+
+    // an extra write is caught by the write hash
+    assert(diff_run(e, diff_step_interp, step_bad_store, UINT64_MAX, &res) == 1);
+    assert(strstr(res.what, "$0300") != NULL);
+    assert(res.trace[(res.trace_start + res.trace_len - 1) % DIFF_TRACE_LEN].pc == 0x4004);
+    diff_result_free(&res);
+
+    // a wrong register, only after the loop
+    assert(diff_run(e, diff_step_predecode, step_bad_inx, UINT64_MAX, &res) == 1);
+    assert(strcmp(res.what, "registers differ") == 0);
+    assert(res.a->pc == 0x400F && res.a->x == 1 && res.b->x == 0);
+    diff_result_free(&res);
+
+    printf("All tests passed.\n");
+    return 0;
+}
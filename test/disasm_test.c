@@ -0,0 +1,83 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "addr_idx.h"
+#include "asm.h"
+#include "disasm.h"
+#include "instr_map.h"
+#include "lib6502emu.h"
+
+/*
+disassemble one line and compare it, as a NUL terminated string
+*/
+void check_line(const uint8_t* code, size_t avail, abs_t adr, const char* expect, int expect_len) {
+    char line[DISASM_LINE_MAX+1];
+    int len;
+    int n = disasm_line(code, avail, adr, line, &len);
+    assert(n <= DISASM_LINE_MAX);
+    line[n] = 0;
+    if (strcmp(line, expect))
+        printf("got '%s' expected '%s'\n", line, expect);
+    assert(!strcmp(line, expect));
+    assert(len == expect_len);
+}
+
+int main() {
+    static emustate emu;
+    emustate* e = &emu;
+    emu_init(e);
+
+    check_line((const uint8_t[]){0xBD, 0x34, 0x12}, 3, 0x4000, "4000  bd 34 12  LDA $1234,X\n", 3);
+    check_line((const uint8_t[]){0xB1, 0x10}, 2, 0x4000, "4000  b1 10     LDA ($10),Y\n", 2);
+    check_line((const uint8_t[]){0xD0, 0xFD}, 2, 0x4003, "4003  d0 fd     BNE $4002\n", 2);
+    check_line((const uint8_t[]){0x0A}, 1, 0x4000, "4000  0a        ASL A\n", 1);
+    check_line((const uint8_t[]){0xEA}, 1, 0xFFFF, "ffff  ea        NOP\n", 1);
+    check_line((const uint8_t[]){0x02}, 1, 0x4000, "4000  02        .byte $02\n", 1);
+    check_line((const uint8_t[]){0x8D, 0x00}, 2, 0x4000, "4000  8d        .byte $8d\n", 1); //cut off
+
+    // every opcode disassembles to text the assembler turns back into the same bytes
+    for (int opc = 0; opc < 256; opc++) {
+        const instr_info* i = instr_map[opc];
+        if (i == NULL)
+            continue;
+        uint8_t code[3] = {opc, 0x80, 0x12};
+        char line[DISASM_LINE_MAX+1];
+        int len;
+        line[disasm_line(code, 3, 0x4000, line, &len)] = 0;
+        assert(len == i->length);
+        asm_result res;
+        assert(asm_assemble(e, line + 16, 0x4000, &res) == 0);
+        assert(res.size == len && memcmp(&ADDR(e, 0x4000), code, len) == 0);
+    }
+
+    // an image split into blocks disassembles the same as in one go
+    static uint8_t image[4096];
+    for (int k = 0; k < sizeof(image); k++)
+        image[k] = (k * 7919) >> 3;
+    static char whole[sizeof(image) * DISASM_LINE_MAX], split[sizeof(image) * DISASM_LINE_MAX];
+    size_t used;
+    size_t whole_len = disasm_image(image, sizeof(image), 0x8000, 1, whole, sizeof(whole), &used);
+    assert(used == sizeof(image));
+    size_t split_len = 0, pos = 0;
+    while (pos < sizeof(image)) {
+        size_t end = pos + 100 < sizeof(image) ? pos + 100 : sizeof(image);
+        split_len += disasm_image(image + pos, end - pos, 0x8000 + pos, end == sizeof(image), split + split_len, 200, &used);
+        pos += used;
+    }
+    assert(split_len == whole_len && !memcmp(whole, split, whole_len));
+
+    // trace records, the last one is incomplete
+    const uint8_t trace[] = {0x00, 0x40, 0xA2, 0x05, 0x02, 0x40, 0xCA, 0x05, 0x40, 0x02, 0x06, 0x40, 0x8D, 0x00};
+    char out[256];
+    size_t n = disasm_trace(trace, sizeof(trace), out, sizeof(out), &used);
+    out[n] = 0;
+    assert(used == 10);
+    assert(!strcmp(out,
+        "4000  a2 05     LDX #$05\n"
+        "4002  ca        DEX\n"
+        "4005  02        .byte $02\n"));
+
+    printf("All tests passed.\n");
+    return 0;
+}
@@ -0,0 +1,117 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "addr_idx.h"
+#include "disasm.h"
+#include "lib6502emu.h"
+#include "predecode.h"
+
+/*
+Klaus Dormann's 6502 functional test, run by `make functest`
+
+Loads the assembled test image (6502_functional_test.bin, a full 64K image, not part of the repo,
+FUNCTEST_BIN points at it) and runs it headless at full speed. The test ends in a jump-to-self: at
+the success address if every test passed, anywhere else at the test that failed. Every SLICE cycles
+one instruction is stepped, and PC not moving means the program is trapped.
+
+Reports pass/fail, the trap address and instruction, the cycle count, wall time and emulated MHz.
+return: 0 if the success trap was reached
+*/
+
+#define SLICE 0x100000
+
+static uint8_t image[0x10000];
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char** argv) {
+    abs_t load = 0x0000, entry = 0x0400, success = 0x3469;
+    uint64_t max_cycles = 200000000;
+    int interp = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "l:e:s:c:i")) != -1) {
+        switch (opt) {
+            case 'l': //load address, hex
+                load = strtoul(optarg, NULL, 16);
+                break;
+            case 'e': //entry point, hex
+                entry = strtoul(optarg, NULL, 16);
+                break;
+            case 's': //address of the success trap, hex
+                success = strtoul(optarg, NULL, 16);
+                break;
+            case 'c':
+                max_cycles = strtoull(optarg, NULL, 10);
+                break;
+            case 'i': //plain interpreter instead of the predecoded dispatch
+                interp = 1;
+                break;
+            default:
+                printf("Usage: %s [-l load_adr] [-e entry] [-s success_adr] [-c max_cycles] [-i] 6502_functional_test.bin\n", argv[0]);
+                return 2;
+        }
+    }
+    if (optind >= argc) {
+        printf("Usage: %s [-l load_adr] [-e entry] [-s success_adr] [-c max_cycles] [-i] 6502_functional_test.bin\n", argv[0]);
+        return 2;
+    }
+
+    FILE* f = fopen(argv[optind], "rb");
+    if (f == NULL) {
+        perror(argv[optind]);
+        return 2;
+    }
+    size_t len = fread(image, 1, sizeof(image), f);
+    fclose(f);
+
+    emustate* emu = emu_create();
+    if (emu == NULL) {
+        printf("Failed to allocate emulator\n");
+        return 2;
+    }
+    decode_cache* cache = emu->cache;
+    if (interp)
+        emu->cache = NULL;
+    emu_load(emu, load, image, len);
+    emu->pc = entry;
+
+    int trapped = 0;
+    double t0 = now_s();
+    while (!trapped && emu->cycles < max_cycles) {
+        emu_run(emu, SLICE);
+        if (emu->stop & STOP_INVALID)
+            break;
+        abs_t pc = emu->pc;
+        emu_step(emu);
+        trapped = emu->pc == pc;
+    }
+    double t = now_s() - t0;
+
+    uint8_t code[3] = {ADDR(emu, emu->pc), ADDR(emu, emu->pc + 1), ADDR(emu, emu->pc + 2)};
+    char line[DISASM_LINE_MAX];
+    int n;
+    disasm_line(code, 3, emu->pc, line, &n);
+    int passed = trapped && emu->pc == success;
+    if (passed)
+        printf("passed: ");
+    else if (trapped)
+        printf("FAILED: trapped at $%04x: ", emu->pc);
+    else if (emu->stop & STOP_INVALID)
+        printf("FAILED: invalid opcode at $%04x: ", emu->pc);
+    else
+        printf("FAILED: no trap after %llu cycles, PC at $%04x: ", (unsigned long long)max_cycles, emu->pc);
+    printf("%s", line);
+    printf("A=%02x X=%02x Y=%02x SR=%02x SP=%02x\n", emu->a, emu->x, emu->y, emu->sr, emu->sp);
+    printf("%llu cycles in %.3fs, %.2f MHz (%s)\n", (unsigned long long)emu->cycles, t,
+        emu->cycles / t / 1e6, interp ? "interpreter" : "predecoded");
+
+    emu->cache = cache;
+    emu_destroy(emu);
+    return !passed;
+}
@@ -3,24 +3,12 @@
 
 #include "emustate.h"
 #include "instructions.h"
-
-void reset_proc(emustate* emu) {
-    emu->a=0;
-    emu->pc=0;
-    emu->sp=0xFF;
-    emu->sr=(1 << 5); //bit 5 should always be set
-    emu->x=0;
-    emu->y=0;
-    for (int i = 0; i < 256; i++) {
-        for (int j = 0; j < 256; j++) {
-            emu->memory[i][j] = 0;
-        }
-    }
-}
+#include "lib6502emu.h"
 
 int main() {
     emustate emu;
-    reset_proc(&emu);
+    emu_init(&emu);
+    emu_track_dirty(&emu, 1); //emu_reset only clears the pages the tests wrote
 
     i_lda_imd(&emu, 0x05); //load 5 into the accumulator
     assert(emu.a == 0x05);
@@ -53,7 +41,7 @@ int main() {
     i_sta_abs_x(&emu, 0x2133); //store A into memory address $2133+X( $2134)
     assert(emu.memory[0x21][0x34] == 0x25);
 
-    reset_proc(&emu);
+    emu_reset(&emu);
 
     //TEST CLEAR/SET
     assert(CHECK(emu.sr, FLAG_C) == 0);
@@ -84,7 +72,7 @@ int main() {
     
     // test ADC 
 
-    reset_proc(&emu);
+    emu_reset(&emu);
 
     // 13 + 211 + CARRY = (A:255, C:0)
     i_sec(&emu);
@@ -157,7 +145,7 @@ int main() {
     assert(CHECK(emu.sr, FLAG_V));  //V must be set
 
     // test ADC in decimal mode
-    reset_proc(&emu);
+    emu_reset(&emu);
     i_sed(&emu);
     i_lda_imd(&emu, 0x10);
     i_adc_imd(&emu, 0x01);
@@ -168,7 +156,7 @@ int main() {
     assert(emu.a == 0x60);
 
     //test AND instruction
-    reset_proc(&emu);
+    emu_reset(&emu);
     i_lda_imd(&emu, 0b11001111);
     i_and_imd(&emu, 0b11110111);
     assert(emu.a == 0b11000111);
@@ -186,7 +174,7 @@ int main() {
     assert(CHECK(emu.sr, FLAG_N));
 
     //test OR instruction
-    reset_proc(&emu);
+    emu_reset(&emu);
     i_lda_imd(&emu, 0b00000000);
     i_ora_imd(&emu, 0b11111111);
     assert(emu.a == 0b11111111);
@@ -206,7 +194,7 @@ int main() {
     assert(!CHECK(emu.sr, FLAG_N));
 
     // test INC, INX, INY, DEC, DEX, DEY
-    reset_proc(&emu);
+    emu_reset(&emu);
 
     i_lda_imd(&emu, 0x35);
     i_sta_abs(&emu, 0x8752);
@@ -265,7 +253,7 @@ int main() {
     // check branch instructions (BCC, BCS, BEQ, BMI, BNE, BPL, BVC, BVS)
 
     //BCS, BCC
-    reset_proc(&emu);
+    emu_reset(&emu);
     i_sec(&emu);
     emu.pc = 100;
     i_bcs_rel(&emu, 5);
@@ -308,7 +296,7 @@ int main() {
     assert(emu.pc == 135);
 
     //SBC
-    reset_proc(&emu);
+    emu_reset(&emu);
     i_lda_imd(&emu, 5);
     i_sec(&emu);
     i_sbc_imd(&emu, 3);
@@ -333,7 +321,7 @@ int main() {
     assert(CHECK(emu.sr, FLAG_N));
 
     //SBC decimal mode
-    reset_proc(&emu);
+    emu_reset(&emu);
     i_sed(&emu);
     i_lda_imd(&emu, 0x20);
     i_sbc_imd(&emu, 0x05);
@@ -343,7 +331,7 @@ int main() {
     assert(emu.a == 0x09);
 
     //test PLP, PLA, PHP, PHA
-    reset_proc(&emu);
+    emu_reset(&emu);
     i_lda_imd(&emu, 20);
     i_pha(&emu);
     i_plp(&emu);
@@ -355,7 +343,7 @@ int main() {
     assert(emu.a == 40);
 
     //test ROL and ROR
-    reset_proc(&emu);
+    emu_reset(&emu);
     i_lda_imd(&emu, 20);
     i_rol_a(&emu);
     assert(emu.a == 20 << 1);
@@ -376,7 +364,7 @@ int main() {
     assert(CHECK(emu.sr, FLAG_N));
 
     //test LSR
-    reset_proc(&emu);
+    emu_reset(&emu);
     i_lda_imd(&emu, 80);
     i_lsr_a(&emu);
     assert(emu.a == 40);
@@ -392,7 +380,7 @@ int main() {
     assert(!CHECK(emu.sr, FLAG_N));
 
     //test BIT
-    reset_proc(&emu);
+    emu_reset(&emu);
     i_ldx_imd(&emu, 0b11001100);
     i_stx_zpg(&emu, 0x10);
     i_lda_imd(&emu, 0b00001000);
@@ -408,13 +396,13 @@ int main() {
     assert(CHECK(emu.sr, FLAG_Z));
 
     //test JMP
-    reset_proc(&emu);
+    emu_reset(&emu);
     emu.pc = 0x328A;
     i_jmp_abs(&emu, 0x40C7);
     assert(emu.pc == 0x40C7);
 
     //test CMP
-    reset_proc(&emu);
+    emu_reset(&emu);
     i_lda_imd(&emu, 0x20);
     i_cmp_imd(&emu, 0x20);
     assert(CHECK(emu.sr, FLAG_Z));
@@ -465,8 +453,29 @@ int main() {
     assert(!CHECK(emu.sr, FLAG_N));
     assert(CHECK(emu.sr, FLAG_C));
 
+    //test N and Z flags set by loads and PLA
+    emu_reset(&emu);
+    i_lda_imd(&emu, 0);
+    assert(CHECK(emu.sr, FLAG_Z));
+    assert(!CHECK(emu.sr, FLAG_N));
+    i_lda_imd(&emu, 0x80);
+    assert(!CHECK(emu.sr, FLAG_Z));
+    assert(CHECK(emu.sr, FLAG_N));
+    i_ldx_imd(&emu, 0);
+    assert(CHECK(emu.sr, FLAG_Z));
+    assert(!CHECK(emu.sr, FLAG_N));
+    i_ldy_imd(&emu, 0xFF);
+    assert(!CHECK(emu.sr, FLAG_Z));
+    assert(CHECK(emu.sr, FLAG_N));
+    i_pha(&emu); //push 0x80
+    i_lda_imd(&emu, 0);
+    i_pla(&emu);
+    assert(emu.a == 0x80);
+    assert(!CHECK(emu.sr, FLAG_Z));
+    assert(CHECK(emu.sr, FLAG_N));
+
     //test RTS, JSR
-    reset_proc(&emu);
+    emu_reset(&emu);
     emu.pc=0x1234;
     i_jsr_abs(&emu, 0xABCD);
     assert(emu.pc == 0xABCD);
@@ -476,7 +485,7 @@ int main() {
 
     //test cycle counts for break instructions
     cycles_t cycles;
-    reset_proc(&emu);
+    emu_reset(&emu);
     i_jmp_abs(&emu, 0x0);
     cycles = i_bcc_rel(&emu, 1);
     assert(emu.pc == 1);
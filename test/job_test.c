@@ -0,0 +1,167 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "job.h"
+#include "job_server.h"
+#include "lib6502emu.h"
+
+static uint8_t buf[JOB_MAX_RECORD + 4];
+
+static void put(uint8_t* p, uint64_t v, int n) {
+    for (int k = 0; k < n; k++, v >>= 8)
+        p[k] = v & 0xFF;
+}
+
+static uint64_t get(const uint8_t* p, int n) {
+    uint64_t v = 0;
+    for (int k = n - 1; k >= 0; k--)
+        v = v << 8 | p[k];
+    return v;
+}
+
+/*
+send a job record, the image loaded and entered at $4000, with ranges given as {adr, len} pairs
+*/
+static void send_job(int fd, uint64_t cycles, const int ranges[][2], int n_ranges, const uint8_t* image, int len) {
+    uint8_t* p = buf + 4;
+    put(p, 0x4000, 2);
+    put(p + 2, 0x4000, 2);
+    put(p + 4, cycles, 8);
+    p[12] = n_ranges;
+    p += JOB_HEADER;
+    for (int k = 0; k < n_ranges; k++, p += 4) {
+        put(p, ranges[k][0], 2);
+        put(p + 2, ranges[k][1], 2);
+    }
+    memcpy(p, image, len);
+    p += len;
+    put(buf, p - buf - 4, 4);
+    assert(write(fd, buf, p - buf) == p - buf);
+}
+
+static void read_all(int fd, uint8_t* out, size_t n) {
+    for (size_t done = 0; done < n; ) {
+        ssize_t r = read(fd, out + done, n - done);
+        assert(r > 0);
+        done += r;
+    }
+}
+
+/*
+read a result record into res
+return: its length, without the length field
+*/
+static size_t read_result(int fd, uint8_t* res) {
+    uint8_t head[4];
+    read_all(fd, head, 4);
+    size_t len = get(head, 4);
+    read_all(fd, res, len);
+    return len;
+}
+
+static int connect_to(const char* path) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un sa = {.sun_family = AF_UNIX};
+    strcpy(sa.sun_path, path);
+    assert(connect(fd, (struct sockaddr*)&sa, sizeof(sa)) == 0);
+    return fd;
+}
+
+int main() {
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/6502emu_job_test.%d", (int)getpid());
+    job_server* srv = job_server_start(path, 2);
+    assert(srv != NULL);
+    int fd = connect_to(path);
+    int other = connect_to(path);
+    static uint8_t res[JOB_RESULT_HEADER + JOB_MAX_OUTPUT];
+
+    const uint8_t store[] = {
+        0xA9, 0x42,       // LDA #$42
+        0x8D, 0x00, 0x02, // STA $0200
+        0xA2, 0x07,       // LDX #7
+        0x02,             // invalid
+    };
+    const int store_ranges[][2] = {{0x0200, 2}, {0x4000, 1}};
+    send_job(fd, 1000, store_ranges, 2, store, sizeof(store));
+    assert(read_result(fd, res) == JOB_RESULT_HEADER + 3);
+    assert(res[0] == STOP_INVALID && get(res + 1, 2) == 0x4007 && res[3] == 0x42 && res[4] == 7 && res[7] == 0xFF);
+    assert(get(res + 8, 8) == 2 + 4 + 2);
+    assert(res[16] == 0x42 && res[17] == 0 && res[18] == 0xA9);
+
+    // the next job on the same worker starts from clean memory and a cycle count of 0
+    const uint8_t load[] = {
+        0xAD, 0x00, 0x02, // LDA $0200
+        0x8D, 0x00, 0x03, // STA $0300
+        0x02,             // invalid
+    };
+    const int load_ranges[][2] = {{0x0300, 1}};
+    send_job(fd, 1000, load_ranges, 1, load, sizeof(load));
+    assert(read_result(fd, res) == JOB_RESULT_HEADER + 1);
+    assert(res[0] == STOP_INVALID && get(res + 8, 8) == 4 + 4 && res[16] == 0);
+
+    // the cycle budget ends a job that does not, on a second connection served in parallel
+    const uint8_t spin[] = {
+        0x4C, 0x00, 0x40, // JMP $4000
+    };
+    send_job(other, 100, NULL, 0, spin, sizeof(spin));
+    assert(read_result(other, res) == JOB_RESULT_HEADER);
+    assert(res[0] == STOP_CYCLES && get(res + 8, 8) >= 100 && get(res + 8, 8) < 103);
+
+    // rejected jobs get an empty result and the stream goes on
+    static int many[JOB_MAX_RANGES + 1][2];
+    send_job(fd, 1000, many, JOB_MAX_RANGES + 1, store, sizeof(store));
+    assert(read_result(fd, res) == JOB_RESULT_HEADER && res[0] == 0 && get(res + 1, 2) == 0);
+    memset(buf, 0, sizeof(buf));
+    put(buf, JOB_MAX_RECORD + 1, 4);
+    assert(write(fd, buf, 4) == 4);
+    for (int left = JOB_MAX_RECORD + 1; left > 0; left -= 0x8000)
+        assert(write(fd, buf + 4, left < 0x8000 ? left : 0x8000) > 0);
+    assert(read_result(fd, res) == JOB_RESULT_HEADER && res[0] == 0);
+    send_job(fd, 1000, store_ranges, 2, store, sizeof(store));
+    assert(read_result(fd, res) == JOB_RESULT_HEADER + 3 && res[16] == 0x42);
+
+    // stopping the server ends a job that would run forever, its result says so
+    send_job(other, UINT64_MAX, NULL, 0, spin, sizeof(spin));
+    usleep(100000);
+    job_server_stop(srv);
+    assert(access(path, F_OK) != 0);
+    assert(read_result(other, res) == JOB_RESULT_HEADER && res[0] == STOP_HOST);
+    close(fd);
+    close(other);
+
+    // a stream of many jobs through one emulator, as bin/6502emu -j - runs them
+    FILE* in = tmpfile();
+    FILE* out = tmpfile();
+    assert(in != NULL && out != NULL);
+    for (int k = 0; k < 1000; k++) {
+        uint8_t prog[] = {0xA9, k & 0xFF, 0x8D, 0x00, 0x02, 0x02}; // LDA #k, STA $0200
+        send_job(fileno(in), 1000, store_ranges, 1, prog, sizeof(prog));
+    }
+    lseek(fileno(in), 0, SEEK_SET);
+    emustate* emu = emu_create();
+    emu_track_dirty(emu, 1);
+    assert(job_serve(emu, fileno(in), fileno(out), NULL) == 0);
+    lseek(fileno(out), 0, SEEK_SET);
+    for (int k = 0; k < 1000; k++) {
+        assert(read_result(fileno(out), res) == JOB_RESULT_HEADER + 2);
+        assert(res[0] == STOP_INVALID && res[3] == (k & 0xFF) && res[16] == (k & 0xFF) && res[17] == 0);
+    }
+    uint8_t more;
+    assert(read(fileno(out), &more, 1) == 0);
+    // a stream cut off in the middle of a record is an error
+    lseek(fileno(in), 0, SEEK_SET);
+    assert(ftruncate(fileno(in), 10) == 0);
+    assert(job_serve(emu, fileno(in), fileno(out), NULL) == -1);
+    emu_destroy(emu);
+    fclose(in);
+    fclose(out);
+
+    printf("All tests passed.\n");
+    return 0;
+}
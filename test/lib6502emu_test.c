@@ -0,0 +1,187 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "addr_idx.h"
+#include "emustate.h"
+#include "lib6502emu.h"
+
+/*
+load a program at adr and point PC at it, everything else is zeroed
+*/
+void load(emustate* emu, abs_t adr, const uint8_t* prog, int len) {
+    memset(emu, 0, sizeof(*emu));
+    emu_init(emu);
+    emu_load(emu, adr, prog, len);
+    emu_set_reg(emu, REG_PC, adr);
+}
+
+/*
+native stand-in for a subroutine that doubles A: squares it instead, so the two are told apart
+*/
+cycles_t hle_square(emustate* emu, void* ctx) {
+    (*(int*)ctx)++;
+    emu->a = emu->a * emu->a;
+    return 1;
+}
+
+int main() {
+    const uint8_t loop[] = {
+        0xA2, 0x05,       // LDX #5
+        0xCA,             // DEX         <- fused with BNE
+        0xD0, 0xFD,       // BNE $4002
+        0xA9, 0x42,       // LDA #$42
+        0x8D, 0x00, 0x02, // STA $0200
+        0xBD, 0x00, 0x02, // LDA $0200,X <- fused with STA
+        0x9D, 0x01, 0x02, // STA $0201,X
+        0xE8,             // INX         <- fused with CPX, INX flags skipped
+        0xE0, 0x01,       // CPX #1
+        0x18,             // CLC         <- fused with ADC
+        0x69, 0x01,       // ADC #1
+        0x02,             // invalid
+    };
+
+    // emu_run with and without a cache agree, and count cycles across calls
+    static emustate plain;
+    load(&plain, 0x4000, loop, sizeof(loop));
+    emustate* lib = emu_create();
+    assert(lib != NULL);
+    emu_load(lib, 0x4000, loop, sizeof(loop));
+    emu_set_reg(lib, REG_PC, 0x4000);
+    uint64_t n = emu_run(lib, 4);
+    assert(n >= 4 && lib->cycles == n);
+    n += emu_run(lib, UINT64_MAX);
+    assert(lib->cycles == n);
+    assert(emu_run(&plain, UINT64_MAX) == n);
+    assert(emu_step(&plain) == 0);
+    assert(emu_get_reg(lib, REG_PC) == emu_get_reg(&plain, REG_PC));
+    assert(emu_get_reg(lib, REG_A) == 0x43 && emu_read(lib, 0x0200) == 0x42);
+    assert(memcmp(lib->mem, plain.mem, sizeof(plain.mem)) == 0);
+
+    // dirty pages: the loaded program and what it stored, checkpoints and reset only touch those
+    static emu_checkpoint cp;
+    static emustate dirty;
+    emu_init(&dirty);
+    emu_track_dirty(&dirty, 1);
+    emu_load(&dirty, 0x4000, loop, sizeof(loop));
+    emu_set_reg(&dirty, REG_PC, 0x4000);
+    emu_checkpoint_save(&dirty, &cp);
+    assert(cp.pages[0x40 >> 3] == 1 << (0x40 & 7) && emu_checkpoint_diff(&dirty, &cp, NULL) == 0);
+    emu_run(&dirty, UINT64_MAX);
+    uint8_t changed[32];
+    assert(emu_checkpoint_diff(&dirty, &cp, changed) == 1 && BITMAP_TEST(changed, 0x02));
+    assert(BITMAP_TEST(dirty.dirty, 0x02) && BITMAP_TEST(dirty.dirty, 0x40) && !BITMAP_TEST(dirty.dirty, 0x03));
+    emu_checkpoint_restore(&dirty, &cp);
+    assert(dirty.pc == 0x4000 && emu_read(&dirty, 0x0200) == 0 && emu_read(&dirty, 0x4000) == 0xA2);
+    assert(!BITMAP_TEST(dirty.dirty, 0x02));
+    assert(emu_run(&dirty, UINT64_MAX) == n && emu_read(&dirty, 0x0200) == 0x42);
+    emu_reset(&dirty);
+    for (int k = 0; k < sizeof(dirty.mem); k++)
+        assert(dirty.mem[k] == 0);
+
+    // emu_run_until: every stop reason, with and without the predecoder
+    const uint8_t stops[] = {
+        0xA2, 0x03,       // LDX #3
+        0xCA,             // DEX         <- breakpoint
+        0xD0, 0xFD,       // BNE $4002
+        0x8E, 0x00, 0x02, // STX $0200   <- watched
+        0x00,             // BRK
+        0x4C, 0x09, 0x40, // JMP $4009
+    };
+    for (int cached = 0; cached <= 1; cached++) {
+        emustate* e = cached ? lib : &plain;
+        emu_reset(e);
+        emu_load(e, 0x4000, stops, sizeof(stops));
+        e->pc = 0x4000;
+        int all = STOP_BREAKPOINT | STOP_WATCH | STOP_BRK | STOP_HOST;
+        emu_set_breakpoint(e, 0x4002, 1);
+        for (int x = 3; x > 0; x--) {
+            assert(emu_run_until(e, 1000, all) == STOP_BREAKPOINT);
+            assert(e->pc == 0x4002 && e->x == x);
+        }
+        emu_set_breakpoint(e, 0x4002, 0);
+        // a breakpoint on the second half of a fused pair that was already decoded
+        e->pc = 0x4000;
+        assert(emu_run(e, 2) == 2 && e->pc == 0x4002);
+        if (emu_run(e, 1) == 2) // DEX, or DEX and BNE as one fused slot
+            emu_run(e, 1);
+        assert(e->pc == 0x4002 && e->x == 2);
+        emu_set_breakpoint(e, 0x4003, 1);
+        assert(emu_run_until(e, 1000, all) == STOP_BREAKPOINT);
+        assert(e->pc == 0x4003 && e->x == 1);
+        emu_set_breakpoint(e, 0x4003, 0);
+        assert(emu_run_until(e, 1000, STOP_BREAKPOINT) == STOP_CYCLES);
+        e->pc = 0x4005;
+        e->x = 0;
+        emu_set_watch(e, 0x0200, 1);
+        assert(emu_run_until(e, 1000, all) == STOP_WATCH);
+        assert(e->pc == 0x4008);
+        assert(emu_run_until(e, 1000, all) == STOP_BRK);
+        assert(e->pc == 0x4009);
+        uint64_t before = e->cycles;
+        assert(emu_run_until(e, 100, all) == STOP_CYCLES);
+        assert(e->cycles - before >= 100 && e->cycles - before < 104);
+        emu_request_stop(e);
+        assert(emu_run_until(e, UINT64_MAX, all) == STOP_HOST);
+        assert(emu_run_until(e, 10, STOP_BRK) == STOP_CYCLES);
+        e->pc = 0x4007; // the 0x02 operand byte of STX
+        assert(emu_run_until(e, 10, 0) == STOP_INVALID);
+        emu_set_watch(e, 0x0200, 0);
+
+        // read watches: only reads of the watched address stop, RMW counts as a read
+        const uint8_t reads[] = {
+            0xAD, 0x05, 0x03, // LDA $0305
+            0xEE, 0x06, 0x03, // INC $0306
+            0xEA,             // NOP
+            0x02,             // invalid
+        };
+        emu_load(e, 0x4000, reads, sizeof(reads));
+        e->pc = 0x4000;
+        emu_set_watch(e, 0x0306, WATCH_READ);
+        emu_set_watch(e, 0x0305, WATCH_WRITE);
+        assert(e->page_flags[0x03] == (PAGE_WATCH_R | PAGE_WATCH_W));
+        assert(emu_run_until(e, 1000, all) == STOP_WATCH);
+        assert(e->pc == 0x4006 && e->watch_hit == 0x0306);
+        emu_set_watch(e, 0x0306, 0);
+        emu_set_watch(e, 0x0305, 0);
+        assert(e->page_flags[0x03] == 0);
+        assert(emu_run_until(e, 1000, all) == STOP_INVALID);
+    }
+
+    // high-level emulation: a JSR to a registered address runs the native function, with and without the cache
+    const uint8_t call[] = {
+        0xA9, 0x07,       // LDA #7
+        0x20, 0x00, 0x41, // JSR $4100
+        0x8D, 0x00, 0x02, // STA $0200
+        0x02,             // invalid
+    };
+    const uint8_t sub[] = {
+        0x0A,             // ASL A
+        0x60,             // RTS
+    };
+    for (int cached = 0; cached <= 1; cached++) {
+        emustate* e = cached ? lib : &plain;
+        emu_reset(e);
+        emu_load(e, 0x4000, call, sizeof(call));
+        emu_load(e, 0x4100, sub, sizeof(sub));
+        int calls = 0;
+        assert(emu_set_hle(e, 0x4100, hle_square, &calls, 20) == 0);
+        e->pc = 0x4000;
+        assert(emu_run(e, UINT64_MAX) == 2 + 21 + 4);
+        assert(calls == 1 && emu_read(e, 0x0200) == 49 && e->sp == 0xFF && e->pc == 0x4008);
+        // disabled, the guest subroutine runs
+        emu_enable_hle(e, 0);
+        e->pc = 0x4000;
+        assert(emu_run(e, UINT64_MAX) == 2 + 6 + 2 + 6 + 4);
+        assert(calls == 1 && emu_read(e, 0x0200) == 14 && e->sp == 0xFF);
+        emu_enable_hle(e, 1);
+        assert(emu_set_hle(e, 0x4100, NULL, NULL, 0) == 0);
+        e->pc = 0x4000;
+        emu_run(e, UINT64_MAX);
+        assert(calls == 1 && emu_read(e, 0x0200) == 14);
+    }
+    emu_destroy(lib);
+
+    printf("All tests passed.\n");
+    return 0;
+}
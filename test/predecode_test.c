@@ -0,0 +1,266 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "addr_idx.h"
+#include "asm.h"
+#include "difftest.h"
+#include "emustate.h"
+#include "instr_map.h"
+#include "lib6502emu.h"
+#include "predecode.h"
+
+/*
+load a program at adr and point PC at it, everything else is zeroed
+*/
+void load(emustate* emu, abs_t adr, const uint8_t* prog, int len) {
+    memset(emu, 0, sizeof(*emu));
+    emu_init(emu);
+    emu_load(emu, adr, prog, len);
+    emu_set_reg(emu, REG_PC, adr);
+}
+
+/*
+reference: decode every instruction from memory, until an invalid opcode
+*/
+uint64_t run_plain(emustate* emu) {
+    uint64_t cycles = 0;
+    while (instr_map[ADDR(emu, emu->pc)] != NULL)
+        cycles += instr_map[read_8(emu)]->exec(emu);
+    return cycles;
+}
+
+/*
+return: non-zero if the registers and memory of a and b are the same
+*/
+int same_state(const emustate* a, const emustate* b) {
+    return a->a == b->a && a->x == b->x && a->y == b->y && a->sr == b->sr && a->sp == b->sp && a->pc == b->pc
+        && memcmp(a->mem, b->mem, sizeof(a->mem)) == 0;
+}
+
+/*
+run prog with the plain interpreter and with the predecoder (plain, fused, fused with idioms), states must match
+*/
+void check_same(const uint8_t* prog, int len, emustate* out) {
+    static emustate ref, emu;
+    load(&ref, 0x4000, prog, len);
+    uint64_t ref_cycles = run_plain(&ref);
+
+    for (int level = 0; level <= 2; level++) {
+        decode_cache* cache = decode_cache_create();
+        assert(cache != NULL);
+        cache->fuse = level >= 1;
+        cache->idioms = level >= 2;
+        load(&emu, 0x4000, prog, len);
+        uint64_t cycles = predecode_run(&emu, cache, UINT64_MAX);
+        assert(cycles == ref_cycles);
+        assert(same_state(&emu, &ref));
+        decode_cache_free(cache);
+    }
+    *out = ref;
+}
+
+/*
+assemble src at $4000 and check_same it
+*/
+void check_same_asm(const char* src, emustate* out) {
+    static emustate tmp;
+    asm_result res;
+    emu_init(&tmp);
+    assert(asm_assemble(&tmp, src, 0x4000, &res) == 0);
+    check_same(tmp.mem + res.start, res.size, out);
+}
+
+int main() {
+    static emustate emu;
+
+    // counted loop and load/store pairs
+    const uint8_t loop[] = {
+        0xA2, 0x05,       // LDX #5
+        0xCA,             // DEX         <- fused with BNE
+        0xD0, 0xFD,       // BNE $4002
+        0xA9, 0x42,       // LDA #$42
+        0x8D, 0x00, 0x02, // STA $0200
+        0xBD, 0x00, 0x02, // LDA $0200,X <- fused with STA
+        0x9D, 0x01, 0x02, // STA $0201,X
+        0xE8,             // INX         <- fused with CPX, INX flags skipped
+        0xE0, 0x01,       // CPX #1
+        0x18,             // CLC         <- fused with ADC
+        0x69, 0x01,       // ADC #1
+        0x02,             // invalid
+    };
+    check_same(loop, sizeof(loop), &emu);
+    assert(emu.x == 1);
+    assert(emu.a == 0x43);
+    assert(emu.memory[0x02][0x00] == 0x42);
+    assert(emu.memory[0x02][0x01] == 0x42);
+    assert(CHECK(emu.sr, FLAG_Z) == 0);
+    assert(emu.pc == 0x4016);
+
+    // self-modifying code: the loop rewrites the operand of the fused STA it just executed
+    const uint8_t selfmod[] = {
+        0xA2, 0x02,       // LDX #2
+        0xA9, 0x11,       // LDA #$11
+        0x85, 0x30,       // STA $30     <- fused with LDA
+        0xA5, 0x30,       // LDA $30
+        0xEE, 0x05, 0x40, // INC $4005   (operand of the STA)
+        0xCA,             // DEX         <- fused with BNE
+        0xD0, 0xF4,       // BNE $4002
+        0x02,             // invalid
+    };
+    check_same(selfmod, sizeof(selfmod), &emu);
+    assert(emu.memory[0x00][0x30] == 0x11);
+    assert(emu.memory[0x00][0x31] == 0x11);
+    assert(emu.memory[0x40][0x05] == 0x32);
+
+    // the first half of a fused pair rewrites the second: the JMP target, then DEX into INX
+    check_same_asm(
+        "        LDA #$0F\n"
+        "        STA $10\n"
+        "        LDA #$40\n"
+        "        STA $11\n"
+        "        LDA #$13\n"
+        "        LDY #0\n"
+        "        STA ($10),Y\n"  // 400C, fused with the JMP, stores to its target's low byte
+        "        JMP $4012\n"
+        "        .byte $02, $02, $02\n", &emu);
+    assert(emu.pc == 0x4013);
+    check_same_asm(
+        "        LDX #4\n"
+        "        LDA #$E8\n"
+        "        STA $4003,X\n"  // 4004, fused with the DEX, stores over it
+        "        DEX\n"
+        "        .byte $02\n", &emu);
+    assert(emu.x == 5 && emu.pc == 0x4008);
+
+    // a watch hit by the first half of a fused pair stops before the second, as on the interpreter
+    const uint8_t watched[] = {
+        0xA2, 0x04,       // LDX #4
+        0x9D, 0x00, 0x03, // STA $0300,X <- watched, fused with DEX
+        0xCA,             // DEX
+        0x02,             // invalid
+    };
+    static emustate unfused;
+    load(&unfused, 0x4000, watched, sizeof(watched));
+    emustate* fused = emu_create();
+    assert(fused != NULL);
+    emu_load(fused, 0x4000, watched, sizeof(watched));
+    emu_set_reg(fused, REG_PC, 0x4000);
+    for (emustate* w = &unfused; w != NULL; w = w == &unfused ? fused : NULL) {
+        emu_set_watch(w, 0x0304, WATCH_WRITE);
+        assert(emu_run_until(w, 1000, STOP_WATCH) == STOP_WATCH);
+        assert(w->pc == 0x4005 && w->x == 4 && w->watch_hit == 0x0304);
+    }
+    emu_destroy(fused);
+
+    // loop idioms: copies and fills (crossing pages, counting up and down, overlapping) and a multiply
+    const char* idioms =
+        "        LDA #$F0\n"
+        "        STA $80\n"
+        "        LDA #$3F\n"
+        "        STA $81\n"
+        "        LDA #$08\n"
+        "        STA $82\n"
+        "        LDA #$50\n"
+        "        STA $83\n"
+        "        LDY #$10\n"
+        "copy:   LDA ($80),Y\n"
+        "        STA ($82),Y\n"
+        "        INY\n"
+        "        BNE copy\n"
+        "        LDA #$AA\n"
+        "        LDY #$F0\n"
+        "fill:   STA ($82),Y\n"
+        "        INY\n"
+        "        BNE fill\n"
+        "        LDX #0\n"
+        "copyx:  LDA $3FF0,X\n"
+        "        STA $5100,X\n"
+        "        DEX\n"
+        "        BNE copyx\n"
+        "        LDA #$55\n"
+        "        LDX #$20\n"
+        "fillx:  STA $5200,X\n"
+        "        INX\n"
+        "        BNE fillx\n"
+        "        LDX #3\n"
+        "filld:  STA $5300,X\n"
+        "        DEX\n"
+        "        BNE filld\n"
+        "        LDA #13\n"
+        "        STA $90\n"
+        "        LDA #11\n"
+        "        STA $91\n"
+        "        LDA #0\n"
+        "        LDX #8\n"
+        "mul:    LSR $90\n"
+        "        BCC skip\n"
+        "        CLC\n"
+        "        ADC $91\n"
+        "skip:   ROR A\n"
+        "        ROR $92\n"
+        "        DEX\n"
+        "        BNE mul\n"
+        "        STA $93\n"
+        "        LDA #$10\n"
+        "        STA $84\n"
+        "        LDA #$11\n"
+        "        STA $86\n"
+        "        LDA #$51\n"
+        "        STA $85\n"
+        "        STA $87\n"
+        "        LDY #0\n"
+        "smear:  LDA ($84),Y\n"
+        "        STA ($86),Y\n"
+        "        INY\n"
+        "        BNE smear\n"
+        "        .byte $02\n";
+    check_same_asm(idioms, &emu);
+    assert(ADDR(&emu, 0x5018) == 0xA9 && ADDR(&emu, 0x5019) == 0xF0);
+    assert(ADDR(&emu, 0x50F7) == 0 && ADDR(&emu, 0x50F8) == 0xAA && ADDR(&emu, 0x50FF) == 0xAA);
+    assert(ADDR(&emu, 0x510F) == 0 && ADDR(&emu, 0x5110) == 0xA9);
+    assert(ADDR(&emu, 0x521F) == 0 && ADDR(&emu, 0x5220) == 0x55 && ADDR(&emu, 0x52FF) == 0x55);
+    assert(ADDR(&emu, 0x5300) == 0 && ADDR(&emu, 0x5303) == 0x55 && ADDR(&emu, 0x5304) == 0);
+    assert((ADDR(&emu, 0x93) << 8 | ADDR(&emu, 0x92)) == 13 * 11);
+    // the last copy runs onto its own source, repeating its first byte
+    assert(ADDR(&emu, 0x5111) == 0xA9 && ADDR(&emu, 0x5210) == 0xA9 && ADDR(&emu, 0x5211) == 0 && emu.a == 0xA9);
+    // the writes are made in the same order too
+    static emustate start;
+    emu_init(&start);
+    assert(asm_assemble(&start, idioms, 0x4000, NULL) == 0);
+    start.pc = 0x4000;
+    diff_result res;
+    assert(diff_run(&start, diff_step_interp, diff_step_predecode, UINT64_MAX, &res) == 0);
+    assert(!res.diverged && res.invalid);
+    diff_result_free(&res);
+
+    // a fill that overwrites its own pointer runs instruction by instruction until it is clear of it
+    const char* clobber =
+        "        LDA #$80\n"
+        "        STA $88\n"
+        "        LDA #0\n"
+        "        STA $89\n"
+        "        TAY\n"
+        "        LDA #$11\n"
+        "fill:   STA ($88),Y\n"
+        "        INY\n"
+        "        BNE fill\n"
+        "        .byte $02\n";
+    check_same_asm(clobber, &emu);
+    assert(ADDR(&emu, 0x88) == 0x11 && ADDR(&emu, 0x89) == 0x11 && ADDR(&emu, 0x1210) == 0x11 && ADDR(&emu, 0x1211) == 0);
+
+    // the host changing code between runs is picked up too
+    decode_cache* cache = decode_cache_create();
+    emustate* e = &emu;
+    load(e, 0x4000, loop, sizeof(loop));
+    predecode_run(e, cache, UINT64_MAX);
+    e->pc = 0x4005;
+    ADDR(e, 0x4006) = 0x99; // LDA #$99
+    predecode_run(e, cache, UINT64_MAX);
+    assert(emu.memory[0x02][0x00] == 0x99);
+    decode_cache_free(cache);
+
+
+    printf("All tests passed.\n");
+    return 0;
+}
@@ -0,0 +1,51 @@
+; test ROM for bin/recomp_test, recompiled by bin/6502rc at build time
+
+total  = $10
+ptr    = $20
+third  = $30
+result = $31
+
+        .org $f000
+reset:  LDX #0
+        LDY #10
+        LDA #0
+        CLC
+sum:    ADC values,X
+        INX
+        DEY
+        BNE sum
+        STA total
+        JSR double
+        JSR patch
+        JSR patched     ; modified by patch, so it has to run in the interpreter
+        LDA #<table
+        STA ptr
+        LDA #>table
+        STA ptr+1
+        LDY #2
+        LDA (ptr),Y
+        STA third
+        SEC
+        SBC #1
+        PHA
+        PLA
+        .byte $02       ; invalid opcode, ends the run
+
+double: ASL total
+        ROL total+1
+        RTS
+
+patch:  LDA #$99
+        STA patched+1
+        RTS
+
+patched:
+        LDA #$11
+        STA result
+        RTS
+
+values: .byte 1, 2, 3, 4, 5, 6, 7, 8, 9, 10
+table:  .byte $10, $20, $30
+
+        .org $fffa
+        .word reset, reset, reset
@@ -0,0 +1,76 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "addr_idx.h"
+#include "asm.h"
+#include "lib6502emu.h"
+#include "recomp.h"
+
+// bin/recomp_rom.c, generated from test/recomp_rom.asm
+extern const recomp_image recomp_rom;
+
+static char source[0x10000];
+
+void load(emustate* emu) {
+    emu_init(emu);
+    assert(asm_assemble(emu, source, 0, NULL) == 0);
+    emu->pc = 0xF000;
+}
+
+void count_slice(emustate* emu, void* ctx) {
+    (*(int*)ctx)++;
+}
+
+int main() {
+    FILE* f = fopen("test/recomp_rom.asm", "r");
+    assert(f != NULL);
+    source[fread(source, 1, sizeof(source)-1, f)] = 0;
+    fclose(f);
+    assert(recomp_rom.n_blocks > 0);
+
+    // the interpreter and the recompiled ROM end in the same state
+    static emustate ref, emu;
+    load(&ref);
+    uint64_t ref_cycles = emu_run(&ref, UINT64_MAX);
+    assert(ref.stop & STOP_INVALID);
+
+    recomp_index* idx = recomp_index_create(&recomp_rom);
+    assert(idx != NULL);
+    load(&emu);
+    emu.stop = 0;
+    uint64_t cycles = recomp_run(&emu, idx, UINT64_MAX);
+    assert(emu.stop & STOP_INVALID);
+    assert(cycles == ref_cycles);
+    assert(emu.a == ref.a && emu.x == ref.x && emu.y == ref.y && emu.sr == ref.sr && emu.sp == ref.sp && emu.pc == ref.pc);
+    assert(memcmp(emu.mem, ref.mem, sizeof(emu.mem)) == 0);
+
+    assert(ADDR(&emu, 0x10) == 110 && ADDR(&emu, 0x11) == 0); //(1+...+10)*2
+    assert(ADDR(&emu, 0x30) == 0x30);
+    assert(ADDR(&emu, 0x31) == 0x99); //the patched block ran as modified
+
+    // a budget stops the run between blocks
+    load(&emu);
+    cycles = recomp_run(&emu, idx, 10);
+    assert(cycles >= 10 && cycles < 10 + 30);
+
+    // through the library: emu_run_until runs the blocks, in slices the host can stop and inspect
+    load(&emu);
+    emu.recomp = idx;
+    int slices = 0;
+    emu.slice_hook = count_slice;
+    emu.slice_ctx = &slices;
+    emu_request_stop(&emu);
+    assert(emu_run_until(&emu, UINT64_MAX, STOP_HOST) == STOP_HOST && emu.cycles == 0 && slices == 0);
+    assert(emu_run_until(&emu, UINT64_MAX, STOP_HOST) == STOP_INVALID && slices == 1);
+    assert(emu.cycles == ref_cycles && emu.pc == ref.pc && memcmp(emu.mem, ref.mem, sizeof(emu.mem)) == 0);
+    // breakpoints fall back to the interpreter
+    load(&emu);
+    emu.recomp = idx;
+    emu_set_breakpoint(&emu, 0xF00B, 1);
+    assert(emu_run_until(&emu, UINT64_MAX, STOP_BREAKPOINT) == STOP_BREAKPOINT && emu.pc == 0xF00B && emu.x == 1);
+
+    recomp_index_free(idx);
+    printf("All tests passed.\n");
+    return 0;
+}
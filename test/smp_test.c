@@ -0,0 +1,101 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "addr_idx.h"
+#include "asm.h"
+#include "lib6502emu.h"
+#include "smp.h"
+
+static void load(smp_system* sys, int k, const char* src) {
+    emustate* cpu = smp_cpu(sys, k);
+    assert(asm_assemble(cpu, src, 0x4000, NULL) == 0);
+    cpu->pc = 0x4000;
+}
+
+/*
+two CPUs: 0 raises a flag, 1 spins until it sees it. Both store to $0220 in the first quantum
+return: the number of times CPU 1 went around its loop
+*/
+static int handshake(uint64_t quantum) {
+    smp_system* sys = smp_create(2, quantum);
+    assert(sys != NULL);
+    smp_share(sys, 0x02, 0x02);
+    load(sys, 0,
+        "        LDA #$AA\n"
+        "        STA $0220\n"
+        "        LDA #1\n"
+        "        STA $0200\n"
+        "        .byte $02\n");
+    load(sys, 1,
+        "        LDA #$BB\n"
+        "        STA $0220\n"
+        "wait:   INC $10\n"
+        "        LDA $0200\n"
+        "        CMP #1\n"
+        "        BNE wait\n"
+        "        .byte $02\n");
+    assert(smp_run(sys, 100000) == 0);
+    assert(smp_clock(sys) < 100000);
+    for (int k = 0; k < 2; k++) {
+        emustate* cpu = smp_cpu(sys, k);
+        // the higher numbered CPU's write wins, the same for both
+        assert(ADDR(cpu, 0x0200) == 1 && ADDR(cpu, 0x0220) == 0xBB);
+        assert(ADDR(cpu, cpu->pc) == 0x02);
+    }
+    // zero page is private
+    assert(ADDR(smp_cpu(sys, 0), 0x10) == 0);
+    int spins = ADDR(smp_cpu(sys, 1), 0x10);
+    smp_free(sys);
+    return spins;
+}
+
+/*
+four CPUs updating counters in shared memory and reading each other's, for a while
+*/
+static smp_system* counters(void) {
+    smp_system* sys = smp_create(4, 50);
+    assert(sys != NULL);
+    smp_share(sys, 0x02, 0x03);
+    for (int k = 0; k < 4; k++) {
+        load(sys, k,
+            "loop:   LDX $00\n"
+            "        INC $0200,X\n"
+            "        LDA $0200\n"
+            "        CLC\n"
+            "        ADC $0201\n"
+            "        ADC $0202\n"
+            "        ADC $0203\n"
+            "        STA $0300,X\n"
+            "        JMP loop\n");
+        emu_write(smp_cpu(sys, k), 0x00, k);
+    }
+    assert(smp_run(sys, 30000) == 4);
+    assert(smp_run(sys, 70000) == 4);
+    assert(smp_clock(sys) == 100000);
+    return sys;
+}
+
+int main() {
+    // a write is seen by the other CPU after the next quantum boundary: 6 cycles, then 14 a spin
+    assert(handshake(100) == 8);
+    assert(handshake(1000) == 72);
+
+    // the result does not depend on thread scheduling, and shared pages agree at every boundary
+    smp_system* a = counters();
+    smp_system* b = counters();
+    for (int k = 0; k < 4; k++) {
+        emustate* ca = smp_cpu(a, k);
+        emustate* cb = smp_cpu(b, k);
+        assert(memcmp(ca->mem, cb->mem, sizeof(ca->mem)) == 0);
+        assert(ca->pc == cb->pc && ca->a == cb->a && ca->cycles == cb->cycles);
+        assert(ca->cycles >= 100000 && ca->cycles < 100000 + 10);
+        assert(memcmp(ca->memory[0x02], smp_cpu(a, 0)->memory[0x02], 0x200) == 0);
+        assert(ADDR(ca, 0x00) == k && ADDR(ca, 0x0200 + k) != 0);
+    }
+    smp_free(a);
+    smp_free(b);
+
+    printf("All tests passed.\n");
+    return 0;
+}
@@ -0,0 +1,561 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "addr_idx.h"
+#include "buscore.h"
+#include "instr_map.h"
+#include "lib6502emu.h"
+
+/*
+Single-step conformance runner
+
+Runs per-opcode test vectors in the SingleStepTests format: a directory with one file per opcode,
+named by its lowercase hex (a9.json), each an array of
+    {"name": ..., "initial": {"pc", "s", "a", "x", "y", "p", "ram": [[adr, val], ...]},
+     "final": {same}, "cycles": [[adr, val, "read"], ...]}
+The initial state is loaded, one instruction is stepped, and registers, the listed RAM and the
+cycle count (the length of "cycles") are compared with the final state. With -b the instruction
+runs on the cycle-stepped bus core, and every bus cycle is compared as well (JSON vectors only,
+the binary form keeps just the count).
+
+Files are streamed through a small buffer and each vector is checked as soon as it is parsed, no
+document is built. Opcodes are handed out to -j worker threads, one emustate each.
+
+-w dir converts the vectors to a compact binary form, dir/a9.bin, which is read the same way and
+much faster to parse. A directory may hold either form for each opcode.
+
+Prints a 16x16 matrix of the percentage of vectors passed per opcode ("--" for no file, "ni" for
+opcodes that are not implemented) and the first failure of each opcode with -v.
+return: 0 if every vector of every implemented opcode passed
+*/
+
+#define SST_RAM_MAX 16
+#define SST_BUS_MAX 16
+#define READ_BUF (1 << 16)
+
+typedef struct sst_state {
+    abs_t pc;
+    uint8_t s, a, x, y, p;
+    int n_ram;
+    struct {abs_t adr; uint8_t val;} ram[SST_RAM_MAX];
+} sst_state;
+
+typedef struct sst_cycle {
+    abs_t adr;
+    uint8_t val;
+    uint8_t write;
+} sst_cycle;
+
+typedef struct sst_vector {
+    char name[64];
+    sst_state initial, final;
+    int cycles;
+    // the first SST_BUS_MAX cycles, n_bus is -1 if they are not known
+    int n_bus;
+    sst_cycle bus[SST_BUS_MAX];
+} sst_vector;
+
+// bus cycles the bus core ran for one vector
+typedef struct bus_trace {
+    int n;
+    sst_cycle bus[SST_BUS_MAX];
+} bus_trace;
+
+typedef struct reader {
+    FILE* f;
+    int binary;
+    int line;
+    size_t pos, len;
+    uint8_t buf[READ_BUF];
+} reader;
+
+typedef struct opcode_result {
+    int present;
+    uint64_t total, passed;
+    char failure[256];
+} opcode_result;
+
+static const char* dir;
+static const char* out_dir;
+static int verbose;
+static int bus_mode;
+static atomic_int next_opcode;
+static opcode_result results[256];
+
+// reading
+
+static int refill(reader* r) {
+    r->pos = 0;
+    r->len = fread(r->buf, 1, READ_BUF, r->f);
+    return r->len > 0;
+}
+
+static int peek(reader* r) {
+    if (r->pos == r->len && !refill(r))
+        return EOF;
+    return r->buf[r->pos];
+}
+
+static int next(reader* r) {
+    int c = peek(r);
+    if (c != EOF)
+        r->pos++;
+    if (c == '\n')
+        r->line++;
+    return c;
+}
+
+static int skip_ws(reader* r) {
+    int c;
+    while ((c = peek(r)) == ' ' || c == '\n' || c == '\r' || c == '\t')
+        next(r);
+    return c;
+}
+
+static int expect(reader* r, int ch) {
+    if (skip_ws(r) != ch)
+        return -1;
+    next(r);
+    return 0;
+}
+
+/*
+read a string into out (truncated to size), the opening quote is the next token
+*/
+static int read_string(reader* r, char* out, size_t size) {
+    if (expect(r, '"'))
+        return -1;
+    size_t n = 0;
+    int c;
+    while ((c = next(r)) != '"') {
+        if (c == EOF)
+            return -1;
+        if (c == '\\')
+            c = next(r);
+        if (n + 1 < size)
+            out[n++] = c;
+    }
+    if (size > 0)
+        out[n] = 0;
+    return 0;
+}
+
+static int read_int(reader* r, long* out) {
+    int c = skip_ws(r);
+    if (c < '0' || c > '9')
+        return -1;
+    long v = 0;
+    while ((c = peek(r)) >= '0' && c <= '9') {
+        v = v * 10 + (c - '0');
+        next(r);
+    }
+    *out = v;
+    return 0;
+}
+
+/*
+after an element of an array or object
+return: 1 if another element follows, 0 at the closing bracket, -1 on a syntax error
+*/
+static int more(reader* r, int close) {
+    int c = skip_ws(r);
+    next(r);
+    if (c == ',')
+        return 1;
+    return c == close ? 0 : -1;
+}
+
+static int skip_value(reader* r) {
+    int c = skip_ws(r);
+    if (c == '"')
+        return read_string(r, NULL, 0);
+    if (c == '[' || c == '{') {
+        int close = c == '[' ? ']' : '}';
+        next(r);
+        if (skip_ws(r) == close) {
+            next(r);
+            return 0;
+        }
+        int m;
+        do {
+            if (close == '}' && (read_string(r, NULL, 0) || expect(r, ':')))
+                return -1;
+            if (skip_value(r))
+                return -1;
+        } while ((m = more(r, close)) == 1);
+        return m;
+    }
+    // numbers, true, false, null
+    while ((c = peek(r)) != EOF && c != ',' && c != ']' && c != '}' && c != ' ' && c != '\n')
+        next(r);
+    return 0;
+}
+
+static int read_ram(reader* r, sst_state* s) {
+    if (expect(r, '['))
+        return -1;
+    if (skip_ws(r) == ']')
+        return next(r), 0;
+    int m;
+    do {
+        long adr, val;
+        if (s->n_ram == SST_RAM_MAX || expect(r, '[') || read_int(r, &adr) || expect(r, ',')
+            || read_int(r, &val) || expect(r, ']'))
+            return -1;
+        s->ram[s->n_ram].adr = adr;
+        s->ram[s->n_ram].val = val;
+        s->n_ram++;
+    } while ((m = more(r, ']')) == 1);
+    return m;
+}
+
+static int read_state(reader* r, sst_state* s) {
+    s->n_ram = 0;
+    if (expect(r, '{'))
+        return -1;
+    int m;
+    do {
+        char key[8];
+        long v = 0;
+        if (read_string(r, key, sizeof(key)) || expect(r, ':'))
+            return -1;
+        if (strcmp(key, "ram") == 0) {
+            if (read_ram(r, s))
+                return -1;
+            continue;
+        }
+        if (read_int(r, &v))
+            return -1;
+        if (strcmp(key, "pc") == 0) s->pc = v;
+        else if (strcmp(key, "s") == 0) s->s = v;
+        else if (strcmp(key, "a") == 0) s->a = v;
+        else if (strcmp(key, "x") == 0) s->x = v;
+        else if (strcmp(key, "y") == 0) s->y = v;
+        else if (strcmp(key, "p") == 0) s->p = v;
+    } while ((m = more(r, '}')) == 1);
+    return m;
+}
+
+static int read_cycles(reader* r, sst_vector* v) {
+    v->cycles = 0;
+    v->n_bus = 0;
+    if (expect(r, '['))
+        return -1;
+    if (skip_ws(r) == ']')
+        return next(r), 0;
+    int m;
+    do {
+        long adr, val;
+        char kind[8];
+        if (expect(r, '[') || read_int(r, &adr) || expect(r, ',') || read_int(r, &val) || expect(r, ',')
+            || read_string(r, kind, sizeof(kind)) || expect(r, ']'))
+            return -1;
+        if (v->n_bus < SST_BUS_MAX)
+            v->bus[v->n_bus++] = (sst_cycle){adr, val, strcmp(kind, "write") == 0};
+        v->cycles++;
+    } while ((m = more(r, ']')) == 1);
+    return m;
+}
+
+static int read_vector_json(reader* r, sst_vector* v) {
+    if (expect(r, '{'))
+        return -1;
+    v->name[0] = 0;
+    int m;
+    do {
+        char key[16];
+        if (read_string(r, key, sizeof(key)) || expect(r, ':'))
+            return -1;
+        int err;
+        if (strcmp(key, "name") == 0)
+            err = read_string(r, v->name, sizeof(v->name));
+        else if (strcmp(key, "initial") == 0)
+            err = read_state(r, &v->initial);
+        else if (strcmp(key, "final") == 0)
+            err = read_state(r, &v->final);
+        else if (strcmp(key, "cycles") == 0)
+            err = read_cycles(r, v);
+        else
+            err = skip_value(r);
+        if (err)
+            return -1;
+    } while ((m = more(r, '}')) == 1);
+    return m;
+}
+
+/*
+binary form of a state: pc (LE), s, a, x, y, p, n_ram, then n_ram times adr (LE), val
+a vector is the initial state, the final state and the cycle count (1 byte), the name is not kept
+*/
+static int read_state_bin(reader* r, sst_state* s) {
+    int b[8];
+    for (int k = 0; k < 8; k++)
+        if ((b[k] = next(r)) == EOF)
+            return -1;
+    *s = (sst_state){b[0] | (b[1] << 8), b[2], b[3], b[4], b[5], b[6], b[7]};
+    if (s->n_ram > SST_RAM_MAX)
+        return -1;
+    for (int k = 0; k < s->n_ram; k++) {
+        int lo = next(r), hi = next(r), val = next(r);
+        if (val == EOF)
+            return -1;
+        s->ram[k].adr = lo | (hi << 8);
+        s->ram[k].val = val;
+    }
+    return 0;
+}
+
+static void write_state_bin(FILE* f, const sst_state* s) {
+    uint8_t b[8 + 3 * SST_RAM_MAX] = {s->pc & 0xFF, s->pc >> 8, s->s, s->a, s->x, s->y, s->p, s->n_ram};
+    for (int k = 0; k < s->n_ram; k++) {
+        b[8 + 3*k] = s->ram[k].adr & 0xFF;
+        b[9 + 3*k] = s->ram[k].adr >> 8;
+        b[10 + 3*k] = s->ram[k].val;
+    }
+    fwrite(b, 1, 8 + 3 * s->n_ram, f);
+}
+
+/*
+return: 1 if a vector was read, 0 at the end of the file, -1 on a syntax error
+*/
+static int read_vector(reader* r, sst_vector* v, int first) {
+    if (r->binary) {
+        if (peek(r) == EOF)
+            return 0;
+        snprintf(v->name, sizeof(v->name), "#%d", r->line++);
+        if (read_state_bin(r, &v->initial) || read_state_bin(r, &v->final) || (v->cycles = next(r)) == EOF)
+            return -1;
+        v->n_bus = -1;
+        return 1;
+    }
+    if (first) {
+        if (expect(r, '['))
+            return -1;
+        if (skip_ws(r) == ']')
+            return 0;
+    } else {
+        int m = more(r, ']');
+        if (m <= 0)
+            return m;
+    }
+    return read_vector_json(r, v) ? -1 : 1;
+}
+
+// running
+
+static void record_cycle(emustate* emu, abs_t adr, uint8_t value, int kind, void* ctx) {
+    bus_trace* trace = ctx;
+    if (trace->n < SST_BUS_MAX)
+        trace->bus[trace->n] = (sst_cycle){adr, value, (kind & BUS_WRITE) != 0};
+    trace->n++;
+}
+
+/*
+return: 0 if the bus cycles in trace are the ones listed in v, else a description of the first difference in msg
+*/
+static int check_bus(const sst_vector* v, const bus_trace* trace, char* msg, size_t size) {
+    for (int k = 0; k < v->n_bus && k < trace->n; k++) {
+        const sst_cycle* got = &trace->bus[k];
+        const sst_cycle* want = &v->bus[k];
+        if (got->adr != want->adr || got->val != want->val || got->write != want->write) {
+            snprintf(msg, size, "%s: cycle %d %s $%04x=%02x, want %s $%04x=%02x", v->name, k + 1,
+                got->write ? "write" : "read", got->adr, got->val, want->write ? "write" : "read", want->adr, want->val);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+return: 0 if the emulator ends in v->final, else a description of the first difference in msg
+*/
+static int run_vector(emustate* emu, const sst_vector* v, char* msg, size_t size) {
+    const sst_state* in = &v->initial;
+    const sst_state* out = &v->final;
+    emu->pc = in->pc; emu->sp = in->s; emu->a = in->a; emu->x = in->x; emu->y = in->y; emu->sr = in->p;
+    for (int k = 0; k < in->n_ram; k++)
+        ADDR(emu, in->ram[k].adr) = in->ram[k].val;
+
+    bus_trace* trace = bus_mode ? emu->bus->hook_ctx : NULL;
+    if (trace != NULL)
+        trace->n = 0;
+    int cycles = emu_step(emu);
+    int err = 0;
+    if (emu->pc != out->pc || emu->sp != out->s || emu->a != out->a || emu->x != out->x
+        || emu->y != out->y || emu->sr != out->p) {
+        snprintf(msg, size, "%s: got pc=%04x s=%02x a=%02x x=%02x y=%02x p=%02x, want pc=%04x s=%02x a=%02x x=%02x y=%02x p=%02x",
+            v->name, emu->pc, emu->sp, emu->a, emu->x, emu->y, emu->sr, out->pc, out->s, out->a, out->x, out->y, out->p);
+        err = 1;
+    } else if (cycles != v->cycles) {
+        snprintf(msg, size, "%s: took %d cycles, want %d", v->name, cycles, v->cycles);
+        err = 1;
+    } else if (trace != NULL) {
+        err = check_bus(v, trace, msg, size);
+    }
+    for (int k = 0; k < out->n_ram; k++) {
+        if (!err && ADDR(emu, out->ram[k].adr) != out->ram[k].val) {
+            snprintf(msg, size, "%s: $%04x is %02x, want %02x", v->name, out->ram[k].adr,
+                ADDR(emu, out->ram[k].adr), out->ram[k].val);
+            err = 1;
+        }
+        ADDR(emu, out->ram[k].adr) = 0;
+    }
+    // the vectors list every address an instruction touches, so this leaves memory clear for the next
+    for (int k = 0; k < in->n_ram; k++)
+        ADDR(emu, in->ram[k].adr) = 0;
+    return err;
+}
+
+static int open_vectors(reader* r, int opc) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%02x.json", dir, opc);
+    r->binary = 0;
+    if ((r->f = fopen(path, "rb")) == NULL) {
+        snprintf(path, sizeof(path), "%s/%02x.bin", dir, opc);
+        r->binary = 1;
+        r->f = fopen(path, "rb");
+    }
+    r->line = r->binary ? 0 : 1;
+    r->pos = r->len = 0;
+    return r->f != NULL;
+}
+
+static void run_opcode(emustate* emu, reader* r, int opc) {
+    opcode_result* res = &results[opc];
+    if (!open_vectors(r, opc))
+        return;
+    res->present = 1;
+
+    FILE* bin = NULL;
+    if (out_dir != NULL) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%02x.bin", out_dir, opc);
+        if ((bin = fopen(path, "wb")) == NULL)
+            perror(path);
+    }
+
+    sst_vector v;
+    char msg[256];
+    int got;
+    for (int first = 1; (got = read_vector(r, &v, first)) == 1; first = 0) {
+        res->total++;
+        if (bin != NULL) {
+            write_state_bin(bin, &v.initial);
+            write_state_bin(bin, &v.final);
+            fputc(v.cycles, bin);
+        }
+        if (instr_map[opc] == NULL)
+            continue;
+        if (run_vector(emu, &v, msg, sizeof(msg)) == 0)
+            res->passed++;
+        else if (res->failure[0] == 0)
+            snprintf(res->failure, sizeof(res->failure), "%s", msg);
+    }
+    if (got < 0)
+        snprintf(res->failure, sizeof(res->failure), "%s %02x: syntax error near %s %d", dir, opc,
+            r->binary ? "vector" : "line", r->line);
+    if (bin != NULL)
+        fclose(bin);
+    fclose(r->f);
+}
+
+static void* worker(void* arg) {
+    emustate* emu = malloc(sizeof(emustate));
+    reader* r = malloc(sizeof(reader));
+    if (emu == NULL || r == NULL) {
+        perror("malloc");
+        exit(1);
+    }
+    emu_init(emu);
+    bus_trace trace;
+    if (bus_mode) {
+        if (emu_set_core(emu, EMU_CORE_BUS) != 0) {
+            perror("malloc");
+            exit(1);
+        }
+        bus_set_hook(emu, record_cycle, &trace);
+    }
+    int opc;
+    while ((opc = atomic_fetch_add(&next_opcode, 1)) < 256)
+        run_opcode(emu, r, opc);
+    emu_set_core(emu, EMU_CORE_INSTR);
+    free(r);
+    free(emu);
+    return NULL;
+}
+
+int main(int argc, char** argv) {
+    int threads = sysconf(_SC_NPROCESSORS_ONLN);
+    int opt;
+    while ((opt = getopt(argc, argv, "j:w:vb")) != -1) {
+        switch (opt) {
+            case 'j':
+                threads = atoi(optarg);
+                break;
+            case 'w':
+                out_dir = optarg;
+                break;
+            case 'v':
+                verbose = 1;
+                break;
+            case 'b':
+                bus_mode = 1;
+                break;
+            default:
+                printf("Usage: %s [-j threads] [-w bin_dir] [-v] [-b] vector_dir\n", argv[0]);
+                return 2;
+        }
+    }
+    if (optind >= argc) {
+        printf("Usage: %s [-j threads] [-w bin_dir] [-v] [-b] vector_dir\n", argv[0]);
+        return 2;
+    }
+    dir = argv[optind];
+    if (threads < 1)
+        threads = 1;
+    if (threads > 256)
+        threads = 256;
+
+    pthread_t tids[256];
+    for (int k = 0; k < threads; k++)
+        pthread_create(&tids[k], NULL, worker, NULL);
+    for (int k = 0; k < threads; k++)
+        pthread_join(tids[k], NULL);
+
+    uint64_t total = 0, passed = 0;
+    int files = 0, failed = 0;
+    printf("   ");
+    for (int lo = 0; lo < 16; lo++)
+        printf("  x%x", lo);
+    for (int opc = 0; opc < 256; opc++) {
+        const opcode_result* res = &results[opc];
+        if ((opc & 0xF) == 0)
+            printf("\n%xx ", opc >> 4);
+        if (!res->present) {
+            printf("  --");
+            continue;
+        }
+        files++;
+        if (instr_map[opc] == NULL) {
+            printf("  ni");
+            continue;
+        }
+        total += res->total;
+        passed += res->passed;
+        if (res->passed != res->total || res->failure[0] != 0)
+            failed++;
+        printf(" %3d", res->total ? (int)(res->passed * 100 / res->total) : 0);
+    }
+    printf("\n\n%d files, %llu of %llu vectors passed, %d opcodes failing\n", files,
+        (unsigned long long)passed, (unsigned long long)total, failed);
+    if (verbose) {
+        for (int opc = 0; opc < 256; opc++)
+            if (results[opc].failure[0] != 0)
+                printf("%02x %s\n", opc, results[opc].failure);
+    }
+    return failed != 0;
+}